@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "dsp.h"
+
+// The SIMD kernels the library has for this host. AVX2 is only checked and timed if the CPU has it.
+enum Backend { BACKEND_ANSI, BACKEND_SSE, BACKEND_AVX2, BACKEND_NEON };
+
+struct BackendInfo {
+    Backend backend;
+    const char* name;
+};
+
+static const BackendInfo BACKENDS[] = {
+    {BACKEND_ANSI, "ansi"},
+#if (dsps_dotprod_f32_sse_enabled == 1)
+    {BACKEND_SSE, "sse"},
+    {BACKEND_AVX2, "avx2"},
+#endif
+#if (dsps_dotprod_f32_neon_enabled == 1)
+    {BACKEND_NEON, "neon"},
+#endif
+};
+
+static const int LENGTHS[] = {1, 3, 4, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 100, 128, 255, 1024};
+
+// A SIMD dot product may be off from the ANSI one by this many float epsilons of the sum of the absolute products.
+// That's far looser than rounding in any order can get for these lengths, but far tighter than a wrong product.
+static const double DOTPROD_TOLERANCE_EPSILONS = 64.0;
+
+struct Options {
+    double seconds = 0.5;  // time spent per throughput measurement
+    const char* output_path = nullptr;
+};
+
+struct Measurement {
+    const char* kernel;
+    const char* backend;
+    int length;
+    double throughput;  // elements per second
+};
+
+static bool backend_supported(Backend backend) {
+#if (dsps_dotprod_f32_sse_enabled == 1)
+    if (backend == BACKEND_AVX2) {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+#endif
+    (void)backend;
+    return true;
+}
+
+static esp_err_t dotprod_f32(Backend backend, const float* src1, const float* src2, float* dest, int len) {
+    switch (backend) {
+#if (dsps_dotprod_f32_sse_enabled == 1)
+        case BACKEND_SSE:
+            return dsps_dotprod_f32_sse(src1, src2, dest, len);
+        case BACKEND_AVX2:
+            return dsps_dotprod_f32_avx2(src1, src2, dest, len);
+#endif
+#if (dsps_dotprod_f32_neon_enabled == 1)
+        case BACKEND_NEON:
+            return dsps_dotprod_f32_neon(src1, src2, dest, len);
+#endif
+        default:
+            return dsps_dotprod_f32_ansi(src1, src2, dest, len);
+    }
+}
+
+static esp_err_t add_s16(Backend backend, const int16_t* input1, const int16_t* input2, int16_t* output, int len,
+                         int step1, int step2, int step_out, int shift) {
+    switch (backend) {
+#if (dsps_add_s16_sse_enabled == 1)
+        case BACKEND_SSE:
+            return dsps_add_s16_sse(input1, input2, output, len, step1, step2, step_out, shift);
+        case BACKEND_AVX2:
+            return dsps_add_s16_avx2(input1, input2, output, len, step1, step2, step_out, shift);
+#endif
+#if (dsps_add_s16_neon_enabled == 1)
+        case BACKEND_NEON:
+            return dsps_add_s16_neon(input1, input2, output, len, step1, step2, step_out, shift);
+#endif
+        default:
+            return dsps_add_s16_ansi(input1, input2, output, len, step1, step2, step_out, shift);
+    }
+}
+
+static esp_err_t mulc_s16(Backend backend, const int16_t* input, int16_t* output, int len, int16_t C, int step_in,
+                          int step_out) {
+    switch (backend) {
+#if (dsps_mulc_s16_sse_enabled == 1)
+        case BACKEND_SSE:
+            return dsps_mulc_s16_sse(input, output, len, C, step_in, step_out);
+        case BACKEND_AVX2:
+            return dsps_mulc_s16_avx2(input, output, len, C, step_in, step_out);
+#endif
+#if (dsps_mulc_s16_neon_enabled == 1)
+        case BACKEND_NEON:
+            return dsps_mulc_s16_neon(input, output, len, C, step_in, step_out);
+#endif
+        default:
+            return dsps_mulc_s16_ansi(input, output, len, C, step_in, step_out);
+    }
+}
+
+// Random Q15 samples, with the extremes mixed in so wraparound and rounding at the limits are exercised
+static std::vector<int16_t> random_q15(std::mt19937& rng, size_t count) {
+    std::uniform_int_distribution<int> sample(-32768, 32767);
+    std::vector<int16_t> samples(count);
+    for (size_t i = 0; i < count; ++i) {
+        const int pick = sample(rng);
+        samples[i] = (int16_t)((pick % 7 == 0) ? -32768 : (pick % 7 == 1) ? 32767 : pick);
+    }
+    return samples;
+}
+
+// Checks one backend against the ANSI kernels on random data at every length (and at an offset of one element, so
+// the loads are unaligned). Prints each mismatch and returns how many there were.
+static int check_backend(Backend backend, const char* name) {
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    double worst_dotprod_epsilons = 0.0;
+    int failures = 0;
+
+    for (int len : LENGTHS) {
+        for (int offset = 0; offset < 2; ++offset) {
+            std::vector<float> a(len + offset), b(len + offset);
+            for (size_t i = 0; i < a.size(); ++i) {
+                a[i] = value(rng);
+                b[i] = value(rng);
+            }
+
+            float expected = 0.0f, actual = 0.0f;
+            double magnitude = 0.0;
+            dsps_dotprod_f32_ansi(&a[offset], &b[offset], &expected, len);
+            dotprod_f32(backend, &a[offset], &b[offset], &actual, len);
+            for (int i = 0; i < len; ++i) {
+                magnitude += std::fabs((double)a[offset + i] * b[offset + i]);
+            }
+
+            const double epsilons = std::fabs((double)actual - expected) / (magnitude * FLT_EPSILON);
+            worst_dotprod_epsilons = std::max(worst_dotprod_epsilons, epsilons);
+            if (!(epsilons <= DOTPROD_TOLERANCE_EPSILONS)) {
+                std::fprintf(stderr, "%s dsps_dotprod_f32 length %d: %.9g instead of %.9g\n", name, len, actual,
+                             expected);
+                ++failures;
+            }
+
+            // The integer kernels must match exactly, with every shift and with strided arrays too
+            const std::vector<int16_t> x = random_q15(rng, 2 * (len + offset)), y = random_q15(rng, 2 * (len + offset));
+            std::vector<int16_t> want(2 * (len + offset)), got(2 * (len + offset));
+
+            for (int step = 1; step <= 2; ++step) {
+                for (int shift = 0; shift <= 16; ++shift) {
+                    dsps_add_s16_ansi(&x[offset], &y[offset], &want[offset], len, step, step, step, shift);
+                    add_s16(backend, &x[offset], &y[offset], &got[offset], len, step, step, step, shift);
+                    if (want != got) {
+                        std::fprintf(stderr, "%s dsps_add_s16 length %d step %d shift %d: mismatch\n", name, len, step,
+                                     shift);
+                        ++failures;
+                    }
+                }
+
+                for (int16_t constant : {(int16_t)-32768, (int16_t)-12345, (int16_t)0, (int16_t)1, (int16_t)16384,
+                                         (int16_t)32767}) {
+                    dsps_mulc_s16_ansi(&x[offset], &want[offset], len, constant, step, step);
+                    mulc_s16(backend, &x[offset], &got[offset], len, constant, step, step);
+                    if (want != got) {
+                        std::fprintf(stderr, "%s dsps_mulc_s16 length %d step %d constant %d: mismatch\n", name, len,
+                                     step, constant);
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+
+    std::fprintf(stderr, "%-5s %s, dot product within %.2f epsilons of ansi\n", name,
+                 failures ? "FAILED" : "matches", worst_dotprod_epsilons);
+    return failures;
+}
+
+// Repeats a call on fixed data for about the given time and returns elements per second
+template <typename Call>
+static double measure(int length, const Options& options, Call call) {
+    size_t calls = 0;
+    const auto start = std::chrono::steady_clock::now();
+    double seconds = 0.0;
+
+    do {
+        for (int i = 0; i < 1000; ++i) {
+            call();
+        }
+        calls += 1000;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < options.seconds);
+
+    return calls * (double)length / seconds;
+}
+
+static void measure_backend(Backend backend, const char* name, const Options& options,
+                            std::vector<Measurement>* measurements) {
+    std::mt19937 rng(2);
+
+    for (int length : {16, 64, 480}) {
+        std::vector<float> a(length, 0.5f), b(length, 0.25f);
+        std::vector<int16_t> x = random_q15(rng, length), y = random_q15(rng, length), out(length);
+        volatile float sink = 0.0f;
+
+        measurements->push_back({"dsps_dotprod_f32", name, length, measure(length, options, [&]() {
+                                     float sum;
+                                     dotprod_f32(backend, a.data(), b.data(), &sum, length);
+                                     sink = sum;
+                                 })});
+        measurements->push_back({"dsps_add_s16", name, length, measure(length, options, [&]() {
+                                     add_s16(backend, x.data(), y.data(), out.data(), length, 1, 1, 1, 1);
+                                 })});
+        measurements->push_back({"dsps_mulc_s16", name, length, measure(length, options, [&]() {
+                                     mulc_s16(backend, x.data(), out.data(), length, 16384, 1, 1);
+                                 })});
+        (void)sink;
+    }
+}
+
+static void print_usage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [options]\n"
+                 "  --check-only            Only check the SIMD kernels against the ANSI ones\n"
+                 "  --seconds <seconds>     Time spent per throughput measurement (0.5)\n"
+                 "  --output <file>         Write the JSON results to a file instead of stdout\n",
+                 program);
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    bool check_only = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--check-only") {
+            check_only = true;
+        } else if ((arg == "--seconds") && (i + 1 < argc)) {
+            options.seconds = std::atof(argv[++i]);
+        } else if ((arg == "--output") && (i + 1 < argc)) {
+            options.output_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.seconds <= 0.0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int failures = 0;
+    for (const BackendInfo& info : BACKENDS) {
+        if ((info.backend != BACKEND_ANSI) && backend_supported(info.backend)) {
+            failures += check_backend(info.backend, info.name);
+        }
+    }
+
+    if (check_only) {
+        return failures ? 1 : 0;
+    }
+
+    std::vector<Measurement> measurements;
+    for (const BackendInfo& info : BACKENDS) {
+        if (backend_supported(info.backend)) {
+            measure_backend(info.backend, info.name, options, &measurements);
+        }
+    }
+
+    FILE* file = stdout;
+    if (options.output_path != nullptr) {
+        file = std::fopen(options.output_path, "w");
+        if (file == nullptr) {
+            std::fprintf(stderr, "Error: Could not open output file: %s\n", options.output_path);
+            return 1;
+        }
+    }
+
+    std::fprintf(file, "{\n  \"host_backend\": \"%s\",\n  \"checks_passed\": %s,\n  \"results\": [\n",
+#if (dsps_host_enabled == 1)
+                 dsps_host_backend(),
+#else
+                 "ansi",
+#endif
+                 failures ? "false" : "true");
+    for (size_t i = 0; i < measurements.size(); ++i) {
+        const Measurement& m = measurements[i];
+        std::fprintf(file, "    {\"kernel\": \"%s\", \"backend\": \"%s\", \"length\": %d, ", m.kernel, m.backend,
+                     m.length);
+        std::fprintf(file, "\"elements_per_second\": %.0f}%s\n", m.throughput,
+                     (i + 1 < measurements.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+
+    if (file != stdout) {
+        std::fclose(file);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "parametric_equalizer.h"
+
+using esp_audio_libs::equalizer::EqualizerBand;
+using esp_audio_libs::equalizer::ParametricEqualizer;
+
+static const double PI = 3.14159265358979323846;
+
+static const float SAMPLE_RATE = 48000.0f;
+static const size_t CHUNK_FRAMES = 480;       // frames handed to process() per call
+static const size_t ANALYSIS_FRAMES = 16384;  // frames fitted per tone
+
+struct Measurement {
+    uint8_t bands;
+    uint8_t channels;
+    double throughput_fps;         // frames per second with the bands held
+    double fading_throughput_fps;  // frames per second with a band changing before every chunk
+};
+
+struct Options {
+    bool quick = false;
+    double seconds = 2.0;  // audio processed per throughput measurement
+    const char* output_path = nullptr;
+};
+
+// Spreads peaking bands across the spectrum, alternating boosts and cuts, so every band is in use
+static EqualizerBand test_band(uint8_t index, uint8_t bands, float gain_db) {
+    EqualizerBand band;
+    band.type = esp_audio_libs::equalizer::EQUALIZER_BAND_PEAKING;
+    band.frequency = 31.25f * std::pow(2.0f, 9.0f * (index + 0.5f) / bands);
+    band.q = 1.4f;
+    band.gain_db = (index & 1) ? -gain_db : gain_db;
+    return band;
+}
+
+static bool configure(ParametricEqualizer& equalizer, uint8_t channels, uint8_t bands) {
+    if (!equalizer.initialize(channels, SAMPLE_RATE, bands)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < bands; ++i) {
+        equalizer.set_band(i, test_band(i, bands, 6.0f));
+    }
+    equalizer.reset();
+    return true;
+}
+
+// Fastest of three passes over noise, with the bands held or with one changing before every chunk
+static double measure_throughput(uint8_t channels, uint8_t bands, bool fading, const Options& options) {
+    ParametricEqualizer equalizer;
+    if (!configure(equalizer, channels, bands)) {
+        return NAN;
+    }
+
+    const size_t frames = (size_t)(options.seconds * SAMPLE_RATE) / CHUNK_FRAMES * CHUNK_FRAMES;
+    std::vector<float> audio(frames * channels);
+    srand(1);
+    for (float& sample : audio) {
+        sample = (rand() / (float)RAND_MAX - 0.5f) * 0.5f;
+    }
+
+    double best_seconds = INFINITY;
+
+    for (int pass = 0; pass < 3; ++pass) {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t used = 0; used < frames; used += CHUNK_FRAMES) {
+            if (fading) {
+                const uint8_t index = (used / CHUNK_FRAMES) % bands;
+                equalizer.set_band(index, test_band(index, bands, (used / CHUNK_FRAMES) % 2 ? 6.0f : 3.0f));
+            }
+            equalizer.process(&audio[used * channels], CHUNK_FRAMES);
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best_seconds = std::min(best_seconds, seconds);
+    }
+
+    return frames / best_seconds;
+}
+
+// Gain of the equalizer at a frequency, from a least squares fit of a tone to its steady-state output
+static double measure_gain_db(ParametricEqualizer& equalizer, double frequency) {
+    equalizer.reset();
+
+    const size_t settle_frames = (size_t)SAMPLE_RATE;
+    std::vector<float> audio(settle_frames + ANALYSIS_FRAMES);
+    for (size_t i = 0; i < audio.size(); ++i) {
+        audio[i] = (float)(0.5 * std::sin(2.0 * PI * frequency * i / SAMPLE_RATE));
+    }
+    equalizer.process(audio.data(), audio.size());
+
+    double ss = 0.0, sc = 0.0, cc = 0.0, ys = 0.0, yc = 0.0;
+    for (size_t i = settle_frames; i < audio.size(); ++i) {
+        const double s = std::sin(2.0 * PI * frequency * i / SAMPLE_RATE);
+        const double c = std::cos(2.0 * PI * frequency * i / SAMPLE_RATE);
+        ss += s * s;
+        sc += s * c;
+        cc += c * c;
+        ys += audio[i] * s;
+        yc += audio[i] * c;
+    }
+    const double determinant = ss * cc - sc * sc;
+    const double a = (ys * cc - yc * sc) / determinant;
+    const double b = (yc * ss - ys * sc) / determinant;
+    return 20.0 * std::log10(std::sqrt(a * a + b * b) / 0.5);
+}
+
+// Largest difference between the gain requested for a lone band and the gain measured at its frequency
+static double measure_accuracy_db() {
+    ParametricEqualizer equalizer;
+    if (!equalizer.initialize(1, SAMPLE_RATE, 1)) {
+        return NAN;
+    }
+
+    double worst = 0.0;
+    for (float frequency : {50.0f, 200.0f, 1000.0f, 5000.0f, 15000.0f}) {
+        for (float gain_db : {-12.0f, -3.0f, 3.0f, 12.0f}) {
+            EqualizerBand band = test_band(0, 1, gain_db);
+            band.frequency = frequency;
+            equalizer.set_band(0, band);
+            worst = std::max(worst, std::fabs(measure_gain_db(equalizer, frequency) - gain_db));
+        }
+    }
+    return worst;
+}
+
+static void print_number(FILE* file, double value, const char* format) {
+    if (std::isfinite(value)) {
+        std::fprintf(file, format, value);
+    } else {
+        std::fprintf(file, "null");
+    }
+}
+
+static void write_json(FILE* file, const std::vector<Measurement>& measurements, double accuracy_db) {
+    std::fprintf(file, "{\n  \"sample_rate\": %.0f,\n  \"chunk_frames\": %zu,\n  \"peak_gain_error_db\": ", SAMPLE_RATE,
+                 CHUNK_FRAMES);
+    print_number(file, accuracy_db, "%.3f");
+    std::fprintf(file, ",\n  \"results\": [\n");
+
+    for (size_t i = 0; i < measurements.size(); ++i) {
+        const Measurement& m = measurements[i];
+        std::fprintf(file, "    {\"bands\": %u, \"channels\": %u, \"throughput_fps\": ", m.bands, m.channels);
+        print_number(file, m.throughput_fps, "%.0f");
+        std::fprintf(file, ", \"realtime_factor\": ");
+        print_number(file, m.throughput_fps / SAMPLE_RATE, "%.1f");
+        std::fprintf(file, ", \"ns_per_band_sample\": ");
+        print_number(file, 1e9 / (m.throughput_fps * m.bands * m.channels), "%.3f");
+        std::fprintf(file, ", \"fading_throughput_fps\": ");
+        print_number(file, m.fading_throughput_fps, "%.0f");
+        std::fprintf(file, "}%s\n", (i + 1 < measurements.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+}
+
+static void print_usage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [options]\n"
+                 "  --quick                 Fewer band and channel counts\n"
+                 "  --seconds <seconds>     Audio processed per throughput measurement (2)\n"
+                 "  --output <file>         Write the JSON results to a file instead of stdout\n",
+                 program);
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--quick") {
+            options.quick = true;
+        } else if ((arg == "--seconds") && (i + 1 < argc)) {
+            options.seconds = std::atof(argv[++i]);
+        } else if ((arg == "--output") && (i + 1 < argc)) {
+            options.output_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.seconds <= 0.0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> band_counts;
+    std::vector<uint8_t> channel_counts;
+
+    if (options.quick) {
+        band_counts = {1, 5};
+        channel_counts = {2};
+    } else {
+        band_counts = {1, 2, 3, 5, 8, 10};
+        channel_counts = {1, 2, 4, 6};
+    }
+
+    std::vector<Measurement> measurements;
+
+    for (uint8_t channels : channel_counts) {
+        for (uint8_t bands : band_counts) {
+            Measurement measurement = {};
+            measurement.bands = bands;
+            measurement.channels = channels;
+            measurement.throughput_fps = measure_throughput(channels, bands, false, options);
+            measurement.fading_throughput_fps = measure_throughput(channels, bands, true, options);
+
+            std::fprintf(stderr, "bands %2u channels %u: %8.1fx realtime, %8.1fx while fading\n", bands, channels,
+                         measurement.throughput_fps / SAMPLE_RATE, measurement.fading_throughput_fps / SAMPLE_RATE);
+
+            measurements.push_back(measurement);
+        }
+    }
+
+    const double accuracy_db = measure_accuracy_db();
+
+    FILE* file = stdout;
+    if (options.output_path != nullptr) {
+        file = std::fopen(options.output_path, "w");
+        if (file == nullptr) {
+            std::fprintf(stderr, "Error: Could not open output file: %s\n", options.output_path);
+            return 1;
+        }
+    }
+
+    write_json(file, measurements, accuracy_db);
+
+    if (file != stdout) {
+        std::fclose(file);
+    }
+
+    return 0;
+}
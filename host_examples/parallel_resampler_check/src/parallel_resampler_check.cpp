@@ -0,0 +1,236 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "parallel_resampler.h"
+
+using esp_audio_libs::resampler::INTERPOLATION_CUBIC;
+using esp_audio_libs::resampler::ParallelResampler;
+using esp_audio_libs::resampler::Resampler;
+using esp_audio_libs::resampler::ResamplerConfiguration;
+using esp_audio_libs::resampler::ResamplerResults;
+
+static const size_t BUFFER_SAMPLES = 960;  // Resampler scratch buffer sizes
+static const size_t THREAD_COUNTS[] = {2, 3, 8};
+
+// Rate pairs covering each engine: fractional and rational ART ratios, IntegerResampler up and down, ASRC-like ratios
+// close to 1, and matching rates
+static const float RATE_PAIRS[][2] = {
+    {44100, 48000}, {48000, 44100}, {48000, 16000}, {16000, 48000},    {96000, 48000},
+    {48000, 8000},  {8000, 48000},  {48000, 96000}, {48000, 12000},    {44100, 47999.3f},
+    {22050, 48000}, {48000, 11025}, {48000, 48000}, {44100, 44100.5f}, {32000, 44100},
+};
+
+struct Variant {
+    const char* name;
+    void (*apply)(ResamplerConfiguration* config);
+};
+
+static const Variant VARIANTS[] = {
+    {"default", [](ResamplerConfiguration*) {}},
+    {"no pre/post filter", [](ResamplerConfiguration* c) { c->use_pre_or_post_filter = false; }},
+    {"rational", [](ResamplerConfiguration* c) { c->use_rational_ratio = true; }},
+    {"low latency", [](ResamplerConfiguration* c) { c->use_low_latency = true; }},
+    {"64 taps, 256 filters",
+     [](ResamplerConfiguration* c) {
+         c->subsample_interpolate = false;
+         c->number_of_taps = 64;
+         c->number_of_filters = 256;
+     }},
+    {"mono, 16 taps",
+     [](ResamplerConfiguration* c) {
+         c->channels = 1;
+         c->number_of_taps = 16;
+     }},
+    {"3 channels, 24 -> 32 bits",
+     [](ResamplerConfiguration* c) {
+         c->channels = 3;
+         c->source_bits_per_sample = 24;
+         c->target_bits_per_sample = 32;
+     }},
+    {"cubic", [](ResamplerConfiguration* c) { c->interpolation_mode = INTERPOLATION_CUBIC; }},
+    {"fixed point", [](ResamplerConfiguration* c) { c->use_fixed_point = true; }},
+    {"asrc",
+     [](ResamplerConfiguration* c) {
+         c->use_asrc = true;
+         c->asrc_target_frames = 1000;
+     }},
+};
+
+struct Options {
+    size_t frames = 200000;  // input frames per recording
+    bool timing = false;
+};
+
+static ResamplerConfiguration base_config(float source_rate, float target_rate) {
+    ResamplerConfiguration config = {};
+    config.source_sample_rate = source_rate;
+    config.target_sample_rate = target_rate;
+    config.source_bits_per_sample = 16;
+    config.target_bits_per_sample = 16;
+    config.channels = 2;
+    config.number_of_taps = 32;
+    config.number_of_filters = 32;
+    config.subsample_interpolate = true;
+    config.use_pre_or_post_filter = true;
+    return config;
+}
+
+// A tone with noise on top, loud enough that some of the 16-bit output clips
+static std::vector<uint8_t> make_recording(const ResamplerConfiguration& config, size_t frames) {
+    const size_t sample_bytes = (config.source_bits_per_sample + 7) / 8;
+    const double full_scale = (double)((1 << (8 * sample_bytes - 1)) - 1);
+    std::vector<uint8_t> recording(frames * config.channels * sample_bytes);
+    uint32_t seed = 1;
+
+    for (size_t i = 0; i < frames * config.channels; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        const double value = 0.6 * std::sin(i * 0.0123) + 0.35 * ((int32_t)seed / 2147483648.0);
+        const int32_t sample = (int32_t)(value * full_scale);
+        std::memcpy(&recording[i * sample_bytes], &sample, sample_bytes);
+    }
+    return recording;
+}
+
+// Resamples the recording with a Resampler and a ParallelResampler and returns true if the results and the output
+// match exactly. The output buffers are filled with a pattern first, so writes past the frames generated show up too.
+static bool check(const char* name, ResamplerConfiguration config, const std::vector<uint8_t>& recording,
+                  size_t input_frames, size_t output_frames_free, size_t threads, bool timing) {
+    const size_t output_bytes = output_frames_free * config.channels * ((config.target_bits_per_sample + 7) / 8);
+    std::vector<uint8_t> serial_output(output_bytes + 16, 0xAA), parallel_output(output_bytes + 16, 0xAA);
+
+    Resampler resampler(BUFFER_SAMPLES * config.channels, BUFFER_SAMPLES * config.channels);
+    ResamplerConfiguration serial_config = config;
+    if (!resampler.initialize(serial_config)) {
+        std::fprintf(stderr, "%s: Resampler::initialize() failed\n", name);
+        return false;
+    }
+
+    ParallelResampler parallel(threads);
+    ResamplerConfiguration parallel_config = config;
+    if (!parallel.initialize(parallel_config)) {
+        std::fprintf(stderr, "%s: ParallelResampler::initialize() failed\n", name);
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const ResamplerResults expected =
+        resampler.resample(recording.data(), serial_output.data(), input_frames, output_frames_free, -1.0f);
+    const auto middle = std::chrono::steady_clock::now();
+    const ResamplerResults results =
+        parallel.resample(recording.data(), parallel_output.data(), input_frames, output_frames_free, -1.0f);
+    const auto end = std::chrono::steady_clock::now();
+
+    if ((results.frames_used != expected.frames_used) || (results.frames_generated != expected.frames_generated) ||
+        (results.predicted_frames_used != expected.predicted_frames_used) ||
+        (results.clipped_samples != expected.clipped_samples) || (parallel_output != serial_output)) {
+        size_t first = 0;
+        while ((first < serial_output.size()) && (serial_output[first] == parallel_output[first])) {
+            ++first;
+        }
+        std::fprintf(stderr,
+                     "MISMATCH %s, %zu output frames free, %zu threads: used %zu/%zu, generated %zu/%zu, "
+                     "predicted %zu/%zu, clipped %u/%u, first different byte %zu\n",
+                     name, output_frames_free, threads, expected.frames_used, results.frames_used,
+                     expected.frames_generated, results.frames_generated, expected.predicted_frames_used,
+                     results.predicted_frames_used, expected.clipped_samples, results.clipped_samples, first);
+        return false;
+    }
+
+    if (timing) {
+        std::printf("%s, %zu threads: serial %.1f ms, parallel %.1f ms\n", name, threads,
+                    std::chrono::duration<double, std::milli>(middle - start).count(),
+                    std::chrono::duration<double, std::milli>(end - middle).count());
+    }
+    return true;
+}
+
+static void print_usage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [options]\n"
+                 "  --frames <frames>       Input frames per recording (200000)\n"
+                 "  --timing                Also time long recordings on 8 threads against one\n",
+                 program);
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "--frames") && (i + 1 < argc)) {
+            options.frames = (size_t)std::atol(argv[++i]);
+        } else if (arg == "--timing") {
+            options.timing = true;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.frames == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int checks = 0, failures = 0;
+
+    for (const auto& pair : RATE_PAIRS) {
+        for (const Variant& variant : VARIANTS) {
+            ResamplerConfiguration config = base_config(pair[0], pair[1]);
+            variant.apply(&config);
+
+            char name[96];
+            std::snprintf(name, sizeof(name), "%.1f -> %.1f Hz, %s", pair[0], pair[1], variant.name);
+
+            const std::vector<uint8_t> recording = make_recording(config, options.frames);
+            const size_t expected_frames = (size_t)(options.frames * (double)pair[1] / pair[0]);
+
+            // Output space to spare, limited to about half, and a few frames short
+            for (size_t output_frames_free : {expected_frames + 1000, expected_frames / 2 + 17, expected_frames - 3}) {
+                for (size_t threads : THREAD_COUNTS) {
+                    ++checks;
+                    if (!check(name, config, recording, options.frames, output_frames_free, threads, false)) {
+                        ++failures;
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%d of %d checks matched the serial Resampler\n", checks - failures, checks);
+
+    if (options.timing) {
+        struct Timed {
+            const char* name;
+            float source_rate;
+            float target_rate;
+            bool rational;
+        };
+        const Timed timed[] = {
+            {"44.1 -> 48 kHz, 64 taps, 512 filters", 44100, 48000, false},
+            {"96 -> 48 kHz, 64 taps", 96000, 48000, false},
+            {"44.1 -> 48 kHz, 64 taps, rational", 44100, 48000, true},
+        };
+
+        for (const Timed& t : timed) {
+            ResamplerConfiguration config = base_config(t.source_rate, t.target_rate);
+            config.number_of_taps = 64;
+            config.number_of_filters = 512;
+            config.use_rational_ratio = t.rational;
+
+            const size_t frames = (size_t)t.source_rate * 60;
+            const std::vector<uint8_t> recording = make_recording(config, frames);
+            if (!check(t.name, config, recording, frames, (size_t)t.target_rate * 61, 8, true)) {
+                ++failures;
+            }
+        }
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,642 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(WRAP_ALLOCATIONS)
+#include <malloc.h>
+#endif
+
+#include "resampler.h"
+#include "resampler_budget.h"
+
+using esp_audio_libs::resampler::IntegerResampler;
+using esp_audio_libs::resampler::Resampler;
+using esp_audio_libs::resampler::ResamplerConfiguration;
+using esp_audio_libs::resampler::ResamplerCostModel;
+using esp_audio_libs::resampler::ResamplerResults;
+
+static const double PI = 3.14159265358979323846;
+
+// Test tones are generated at -6 dBFS as 24-bit samples and read back as 32-bit samples, so the measurements aren't
+// limited by 16-bit quantization noise
+static const double TONE_AMPLITUDE = 0.5;
+static const uint8_t CHANNELS = 2;
+static const size_t ANALYSIS_FRAMES = 16384;  // output frames fitted per tone
+static const size_t CHUNK_FRAMES = 480;       // input frames handed to resample() per call
+static const size_t BUFFER_SAMPLES = 4096;    // Resampler scratch buffer sizes
+
+struct SweepPoint {
+    float source_rate;
+    float target_rate;
+    uint16_t number_of_taps;
+    uint16_t number_of_filters;
+    bool subsample_interpolate;
+};
+
+struct Measurement {
+    SweepPoint point;
+    bool integer_engine;
+    double throughput_fps;        // input frames per second
+    double multiplies_per_frame;  // filter multiplies per output frame (estimate_multiplies_per_frame())
+    long long memory_bytes;       // heap allocated by initialize(), -1 if unknown
+    double latency_frames;
+    double passband_edge_hz;
+    double passband_ripple_db;
+    double stopband_rejection_db;  // NAN if there's no stopband to measure
+    double thd_n_1k_db;            // NAN if 1 kHz is outside the passband
+    double thd_n_worst_db;
+};
+
+struct Options {
+    bool quick = false;
+    bool presets = false;
+    bool pre_or_post_filter = true;
+    bool fixed_point = false;     // use_fixed_point
+    bool rational_ratio = false;  // use_rational_ratio
+    bool low_latency = false;     // use_low_latency
+    double passband = 0.8;  // passband edge as a fraction of the lower Nyquist frequency
+    double seconds = 5.0;   // audio processed per throughput measurement
+    const char* output_path = nullptr;
+};
+
+#if defined(WRAP_ALLOCATIONS)
+// The library's malloc, calloc, and free calls are redirected here at link time (see CMakeLists.txt) so the heap it
+// holds can be counted exactly
+static long long library_heap_bytes = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void __real_free(void* ptr);
+
+void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    if (ptr != nullptr) {
+        library_heap_bytes += malloc_usable_size(ptr);
+    }
+    return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* ptr = __real_calloc(count, size);
+    if (ptr != nullptr) {
+        library_heap_bytes += malloc_usable_size(ptr);
+    }
+    return ptr;
+}
+
+void __wrap_free(void* ptr) {
+    if (ptr != nullptr) {
+        library_heap_bytes -= malloc_usable_size(ptr);
+    }
+    __real_free(ptr);
+}
+}
+#endif
+
+// Heap currently held by the library, or -1 if it can't be measured on this platform
+static long long heap_in_use() {
+#if defined(WRAP_ALLOCATIONS)
+    return library_heap_bytes;
+#else
+    return -1;
+#endif
+}
+
+static ResamplerConfiguration make_config(const SweepPoint& point, uint8_t source_bits, uint8_t target_bits,
+                                          const Options& options) {
+    ResamplerConfiguration config = {};
+    config.source_sample_rate = point.source_rate;
+    config.target_sample_rate = point.target_rate;
+    config.source_bits_per_sample = source_bits;
+    config.target_bits_per_sample = target_bits;
+    config.channels = CHANNELS;
+    config.use_pre_or_post_filter = options.pre_or_post_filter;
+    config.use_fixed_point = options.fixed_point;
+    config.use_rational_ratio = options.rational_ratio;
+    config.use_low_latency = options.low_latency;
+    config.subsample_interpolate = point.subsample_interpolate;
+    config.number_of_taps = point.number_of_taps;
+    config.number_of_filters = point.number_of_filters;
+    return config;
+}
+
+// Resamples a 24-bit tone at frequency_hz (identical on every channel) and returns the first channel of the steady
+// state output, skipping the filter delay and start-up transient
+static std::vector<double> resample_tone(const SweepPoint& point, double frequency_hz, const Options& options) {
+    ResamplerConfiguration config = make_config(point, 24, 32, options);
+    Resampler resampler(BUFFER_SAMPLES, BUFFER_SAMPLES);
+    if (!resampler.initialize(config)) {
+        return std::vector<double>();
+    }
+
+    const double ratio = (double)point.target_rate / point.source_rate;
+    const size_t skip_frames = (size_t)std::ceil(resampler.latency_frames()) + 4 * point.number_of_taps * ratio + 256;
+    const size_t output_frames = skip_frames + ANALYSIS_FRAMES;
+    const size_t input_frames = (size_t)std::ceil(output_frames / ratio) + 4 * point.number_of_taps + 64;
+
+    std::vector<uint8_t> input(input_frames * CHANNELS * 3);
+    for (size_t i = 0; i < input_frames; ++i) {
+        const int32_t sample =
+            (int32_t)std::lrint(TONE_AMPLITUDE * 8388608.0 * std::sin(2.0 * PI * frequency_hz * i / point.source_rate));
+        for (int c = 0; c < CHANNELS; ++c) {
+            uint8_t* bytes = &input[(i * CHANNELS + c) * 3];
+            bytes[0] = (uint8_t)sample;
+            bytes[1] = (uint8_t)(sample >> 8);
+            bytes[2] = (uint8_t)(sample >> 16);
+        }
+    }
+
+    std::vector<int32_t> output(output_frames * CHANNELS);
+    size_t used = 0, generated = 0;
+
+    while ((used < input_frames) && (generated < output_frames)) {
+        ResamplerResults results = resampler.resample(&input[used * CHANNELS * 3],
+                                                      (uint8_t*)&output[generated * CHANNELS],
+                                                      std::min(CHUNK_FRAMES, input_frames - used),
+                                                      output_frames - generated, 0.0f);
+        if ((results.frames_used == 0) && (results.frames_generated == 0)) {
+            break;
+        }
+        used += results.frames_used;
+        generated += results.frames_generated;
+    }
+
+    std::vector<double> steady;
+    for (size_t i = skip_frames; i < generated; ++i) {
+        steady.push_back(output[i * CHANNELS] / 2147483648.0);
+    }
+    return steady;
+}
+
+// Least-squares fit of sinusoids at the given frequencies (in cycles per sample). Stores each one's amplitude and
+// returns the RMS of what's left over.
+static double fit_sinusoids(const std::vector<double>& signal, const std::vector<double>& frequencies,
+                            std::vector<double>* amplitudes) {
+    const size_t terms = 2 * frequencies.size();
+    std::vector<double> normal(terms * (terms + 1), 0.0);  // augmented normal equations, one row per basis function
+    std::vector<double> basis(terms);
+
+    for (size_t n = 0; n < signal.size(); ++n) {
+        for (size_t k = 0; k < frequencies.size(); ++k) {
+            basis[2 * k] = std::cos(2.0 * PI * frequencies[k] * n);
+            basis[2 * k + 1] = std::sin(2.0 * PI * frequencies[k] * n);
+        }
+        for (size_t r = 0; r < terms; ++r) {
+            for (size_t c = 0; c < terms; ++c) {
+                normal[r * (terms + 1) + c] += basis[r] * basis[c];
+            }
+            normal[r * (terms + 1) + terms] += basis[r] * signal[n];
+        }
+    }
+
+    // Gaussian elimination with partial pivoting
+    for (size_t col = 0; col < terms; ++col) {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < terms; ++r) {
+            if (std::fabs(normal[r * (terms + 1) + col]) > std::fabs(normal[pivot * (terms + 1) + col])) {
+                pivot = r;
+            }
+        }
+        for (size_t c = 0; c <= terms; ++c) {
+            std::swap(normal[col * (terms + 1) + c], normal[pivot * (terms + 1) + c]);
+        }
+        for (size_t r = 0; r < terms; ++r) {
+            if (r == col) {
+                continue;
+            }
+            const double factor = normal[r * (terms + 1) + col] / normal[col * (terms + 1) + col];
+            for (size_t c = col; c <= terms; ++c) {
+                normal[r * (terms + 1) + c] -= factor * normal[col * (terms + 1) + c];
+            }
+        }
+    }
+
+    std::vector<double> weights(terms);
+    for (size_t r = 0; r < terms; ++r) {
+        weights[r] = normal[r * (terms + 1) + terms] / normal[r * (terms + 1) + r];
+    }
+
+    amplitudes->clear();
+    for (size_t k = 0; k < frequencies.size(); ++k) {
+        amplitudes->push_back(std::hypot(weights[2 * k], weights[2 * k + 1]));
+    }
+
+    double residual = 0.0;
+    for (size_t n = 0; n < signal.size(); ++n) {
+        double fitted = 0.0;
+        for (size_t k = 0; k < frequencies.size(); ++k) {
+            fitted += weights[2 * k] * std::cos(2.0 * PI * frequencies[k] * n) +
+                      weights[2 * k + 1] * std::sin(2.0 * PI * frequencies[k] * n);
+        }
+        residual += (signal[n] - fitted) * (signal[n] - fitted);
+    }
+    return std::sqrt(residual / std::max<size_t>(signal.size(), 1));
+}
+
+static double rms(const std::vector<double>& signal) {
+    double sum = 0.0;
+    for (double sample : signal) {
+        sum += sample * sample;
+    }
+    return std::sqrt(sum / std::max<size_t>(signal.size(), 1));
+}
+
+static double to_db(double ratio) { return 20.0 * std::log10(std::max(ratio, 1e-12)); }
+
+// Folds a frequency into the range between 0 and the Nyquist frequency of the given rate
+static double fold_frequency(double frequency_hz, double rate) {
+    double folded = std::fmod(frequency_hz, rate);
+    return (folded > rate / 2.0) ? rate - folded : folded;
+}
+
+// Stepped sine sweep through the passband for the gain, THD+N, and (when upsampling) image levels, and through the
+// band that aliases into the output (when downsampling)
+static void measure_quality(const SweepPoint& point, const Options& options, Measurement* measurement) {
+    const double source = point.source_rate;
+    const double target = point.target_rate;
+    const double edge = options.passband * std::min(source, target) / 2.0;
+    const int passband_tones = options.quick ? 6 : 12;
+
+    measurement->passband_edge_hz = edge;
+    measurement->thd_n_1k_db = NAN;
+    measurement->thd_n_worst_db = -INFINITY;
+    measurement->stopband_rejection_db = INFINITY;
+
+    double max_gain = -INFINITY;
+    double min_gain = INFINITY;
+    std::vector<double> amplitudes;
+
+    for (int t = 0; t <= passband_tones; ++t) {
+        // tone 0 is 1 kHz (if it's in the passband), the rest are spread evenly up to the edge
+        const double frequency = (t == 0) ? 1000.0 : edge * t / passband_tones;
+        if ((t == 0) && (frequency > edge)) {
+            continue;
+        }
+
+        const std::vector<double> output = resample_tone(point, frequency, options);
+        std::vector<double> frequencies(1, frequency / target);
+
+        const double residual = fit_sinusoids(output, frequencies, &amplitudes);
+        const double gain_db = to_db(amplitudes[0] / TONE_AMPLITUDE);
+        const double thd_n_db = to_db(residual / (amplitudes[0] / std::sqrt(2.0)));
+
+        max_gain = std::max(max_gain, gain_db);
+        min_gain = std::min(min_gain, gain_db);
+        measurement->thd_n_worst_db = std::max(measurement->thd_n_worst_db, thd_n_db);
+        if (t == 0) {
+            measurement->thd_n_1k_db = thd_n_db;
+        }
+
+        // When upsampling, the first image of the tone lands in the stopband
+        const double image = fold_frequency(source - frequency, target);
+        if ((target > source) && (std::fabs(image - frequency) > 100.0) && (image > 100.0)) {
+            frequencies.push_back(image / target);
+            fit_sinusoids(output, frequencies, &amplitudes);
+            measurement->stopband_rejection_db =
+                std::min(measurement->stopband_rejection_db, to_db(amplitudes[0] / amplitudes[1]));
+        }
+    }
+
+    measurement->passband_ripple_db = max_gain - min_gain;
+
+    // When downsampling, tones between the output and input Nyquist frequencies must not reach the output. The stopband
+    // starts where aliases would land in the passband, or just above the output Nyquist if the input doesn't go that
+    // high (close ratios).
+    if (target < source) {
+        const double top = 0.98 * source / 2.0;
+        double bottom = target - edge;
+        if (bottom >= top) {
+            bottom = 1.05 * target / 2.0;
+        }
+
+        const int stopband_tones = options.quick ? 3 : 6;
+        for (int t = 0; t < stopband_tones; ++t) {
+            const double frequency = bottom + (top - bottom) * t / std::max(stopband_tones - 1, 1);
+            const std::vector<double> output = resample_tone(point, frequency, options);
+            const double leak = rms(output) / (TONE_AMPLITUDE / std::sqrt(2.0));
+            measurement->stopband_rejection_db = std::min(measurement->stopband_rejection_db, -to_db(leak));
+        }
+    }
+
+    if (std::isinf(measurement->stopband_rejection_db)) {
+        measurement->stopband_rejection_db = NAN;
+    }
+}
+
+// Streams 16-bit stereo noise through the resampler in CHUNK_FRAMES pieces, keeping the fastest of three passes
+static void measure_throughput(const SweepPoint& point, const Options& options, Measurement* measurement) {
+    ResamplerConfiguration config = make_config(point, 16, 16, options);
+
+    // The filter cache would otherwise hide the filters allocated by an earlier sweep point with the same filters
+    esp_audio_libs::art_resampler::resampleFlushFilterCache();
+    const long long heap_before = heap_in_use();
+
+    Resampler resampler(BUFFER_SAMPLES, BUFFER_SAMPLES);
+    if (!resampler.initialize(config)) {
+        measurement->throughput_fps = NAN;
+        measurement->memory_bytes = -1;
+        return;
+    }
+
+    const long long heap_after = heap_in_use();
+    measurement->memory_bytes = ((heap_before < 0) || (heap_after < 0)) ? -1 : heap_after - heap_before;
+    measurement->latency_frames = resampler.latency_frames();
+    measurement->multiplies_per_frame = esp_audio_libs::resampler::estimate_multiplies_per_frame(config);
+
+    const size_t input_frames = (size_t)(options.seconds * point.source_rate);
+    const double ratio = (double)point.target_rate / point.source_rate;
+    const size_t output_frames = (size_t)std::ceil(CHUNK_FRAMES * ratio) + 16;
+
+    std::vector<int16_t> input(input_frames * CHANNELS);
+    std::vector<int16_t> output(output_frames * CHANNELS);
+    uint32_t seed = 1;
+    for (int16_t& sample : input) {
+        seed = seed * 1664525u + 1013904223u;
+        sample = (int16_t)((int32_t)(seed >> 16) - 32768) / 2;
+    }
+
+    double best_seconds = INFINITY;
+    for (int pass = 0; pass < 3; ++pass) {
+        const auto start = std::chrono::steady_clock::now();
+        size_t used = 0;
+
+        while (used < input_frames) {
+            ResamplerResults results = resampler.resample((const uint8_t*)&input[used * CHANNELS],
+                                                          (uint8_t*)output.data(),
+                                                          std::min(CHUNK_FRAMES, input_frames - used), output_frames,
+                                                          0.0f);
+            if (results.frames_used == 0) {
+                break;
+            }
+            used += results.frames_used;
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best_seconds = std::min(best_seconds, seconds);
+    }
+
+    measurement->throughput_fps = input_frames / best_seconds;
+}
+
+static void print_number(FILE* file, double value, const char* format) {
+    if (std::isfinite(value)) {
+        std::fprintf(file, format, value);
+    } else {
+        std::fprintf(file, "null");
+    }
+}
+
+static void print_point(FILE* file, const SweepPoint& point, bool integer_engine) {
+    std::fprintf(file,
+                 "\"source_rate\": %.0f, \"target_rate\": %.0f, \"engine\": \"%s\", \"number_of_taps\": %u, "
+                 "\"number_of_filters\": %u, \"subsample_interpolate\": %s",
+                 point.source_rate, point.target_rate, integer_engine ? "integer" : "art", point.number_of_taps,
+                 point.number_of_filters, point.subsample_interpolate ? "true" : "false");
+}
+
+struct PresetTier {
+    const char* name;
+    double min_quality_db;  // required stopband rejection and THD+N (as a positive number) everywhere in the passband
+};
+
+static const PresetTier PRESET_TIERS[] = {{"economy", 50.0}, {"balanced", 70.0}, {"high", 90.0}};
+
+// The fastest measured configuration of a rate pair that meets a tier's quality, or nullptr if none does
+static const Measurement* choose_preset(const std::vector<Measurement>& measurements, float source_rate,
+                                        float target_rate, const PresetTier& tier) {
+    const Measurement* best = nullptr;
+    for (const Measurement& measurement : measurements) {
+        if ((measurement.point.source_rate != source_rate) || (measurement.point.target_rate != target_rate)) {
+            continue;
+        }
+        const bool rejects = std::isnan(measurement.stopband_rejection_db) ||
+                             (measurement.stopband_rejection_db >= tier.min_quality_db);
+        if (!rejects || (measurement.thd_n_worst_db > -tier.min_quality_db)) {
+            continue;
+        }
+        if ((best == nullptr) || (measurement.throughput_fps > best->throughput_fps)) {
+            best = &measurement;
+        }
+    }
+    return best;
+}
+
+// Least squares fit of the library's cost model to the measured time per output frame of a rate pair, in nanoseconds
+static ResamplerCostModel fit_cost_model(const std::vector<Measurement>& measurements, float source_rate,
+                                         float target_rate) {
+    double n = 0.0, sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_xy = 0.0;
+    for (const Measurement& m : measurements) {
+        if ((m.point.source_rate != source_rate) || (m.point.target_rate != target_rate) ||
+            !std::isfinite(m.throughput_fps)) {
+            continue;
+        }
+        const double x = m.multiplies_per_frame;
+        const double y = 1e9 * m.point.source_rate / (m.throughput_fps * m.point.target_rate);
+        n += 1.0;
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+
+    ResamplerCostModel model = {};
+    const double denominator = n * sum_xx - sum_x * sum_x;
+    if (denominator > 0.0) {
+        model.multiply_cost = (float)((n * sum_xy - sum_x * sum_y) / denominator);
+        model.frame_cost = (float)((sum_y - model.multiply_cost * sum_x) / n);
+    }
+    return model;
+}
+
+static void write_json(FILE* file, const std::vector<Measurement>& measurements,
+                       const std::vector<std::pair<float, float>>& rate_pairs, const Options& options) {
+    std::fprintf(file, "{\n  \"channels\": %u,\n  \"pre_or_post_filter\": %s,\n  \"passband\": %.3f,\n", CHANNELS,
+                 options.pre_or_post_filter ? "true" : "false", options.passband);
+    std::fprintf(file, "  \"fixed_point\": %s,\n  \"rational_ratio\": %s,\n  \"low_latency\": %s,\n",
+                 options.fixed_point ? "true" : "false", options.rational_ratio ? "true" : "false",
+                 options.low_latency ? "true" : "false");
+    std::fprintf(file, "  \"results\": [\n");
+
+    for (size_t i = 0; i < measurements.size(); ++i) {
+        const Measurement& m = measurements[i];
+        std::fprintf(file, "    {");
+        print_point(file, m.point, m.integer_engine);
+        std::fprintf(file, ", \"throughput_fps\": ");
+        print_number(file, m.throughput_fps, "%.0f");
+        std::fprintf(file, ", \"realtime_factor\": ");
+        print_number(file, m.throughput_fps / m.point.source_rate, "%.1f");
+        std::fprintf(file, ", \"multiplies_per_frame\": ");
+        print_number(file, m.multiplies_per_frame, "%.1f");
+        std::fprintf(file, ", \"memory_bytes\": ");
+        print_number(file, m.memory_bytes < 0 ? NAN : (double)m.memory_bytes, "%.0f");
+        std::fprintf(file, ", \"latency_frames\": ");
+        print_number(file, m.latency_frames, "%.2f");
+        std::fprintf(file, ", \"passband_edge_hz\": ");
+        print_number(file, m.passband_edge_hz, "%.0f");
+        std::fprintf(file, ", \"passband_ripple_db\": ");
+        print_number(file, m.passband_ripple_db, "%.3f");
+        std::fprintf(file, ", \"stopband_rejection_db\": ");
+        print_number(file, m.stopband_rejection_db, "%.1f");
+        std::fprintf(file, ", \"thd_n_1k_db\": ");
+        print_number(file, m.thd_n_1k_db, "%.1f");
+        std::fprintf(file, ", \"thd_n_worst_db\": ");
+        print_number(file, m.thd_n_worst_db, "%.1f");
+        std::fprintf(file, "}%s\n", (i + 1 < measurements.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ],\n  \"cost_models\": [\n");
+
+    for (size_t i = 0; i < rate_pairs.size(); ++i) {
+        const ResamplerCostModel model = fit_cost_model(measurements, rate_pairs[i].first, rate_pairs[i].second);
+        std::fprintf(file,
+                     "    {\"source_rate\": %.0f, \"target_rate\": %.0f, \"frame_ns\": %.2f, "
+                     "\"multiply_ns\": %.4f}%s\n",
+                     rate_pairs[i].first, rate_pairs[i].second, model.frame_cost, model.multiply_cost,
+                     (i + 1 < rate_pairs.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]");
+
+    if (options.presets) {
+        std::fprintf(file, ",\n  \"presets\": [\n");
+        bool first = true;
+        for (const auto& pair : rate_pairs) {
+            for (const PresetTier& tier : PRESET_TIERS) {
+                const Measurement* best = choose_preset(measurements, pair.first, pair.second, tier);
+                if (best == nullptr) {
+                    continue;
+                }
+                std::fprintf(file, "%s    {\"tier\": \"%s\", \"min_quality_db\": %.0f, ", first ? "" : ",\n",
+                             tier.name, tier.min_quality_db);
+                print_point(file, best->point, best->integer_engine);
+                std::fprintf(file, ", \"throughput_fps\": %.0f}", best->throughput_fps);
+                first = false;
+            }
+        }
+        std::fprintf(file, "\n  ]");
+    }
+    std::fprintf(file, "\n}\n");
+}
+
+static void print_usage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [options]\n"
+                 "  --quick                 Fewer rate pairs, configurations, and test tones\n"
+                 "  --presets               Add the fastest configuration meeting each quality tier per rate pair\n"
+                 "  --no-pre-post-filter    Measure without the optional pre/post biquad\n"
+                 "  --fixed-point           Measure the fixed-point path (use_fixed_point)\n"
+                 "  --rational              Use exact rational phase stepping where the rates allow it\n"
+                 "  --low-latency           Measure the low-latency filters (use_low_latency)\n"
+                 "  --passband <fraction>   Passband edge as a fraction of the lower Nyquist frequency (0.8)\n"
+                 "  --seconds <seconds>     Audio processed per throughput measurement (5)\n"
+                 "  --output <file>         Write the JSON results to a file instead of stdout\n",
+                 program);
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--presets") {
+            options.presets = true;
+        } else if (arg == "--no-pre-post-filter") {
+            options.pre_or_post_filter = false;
+        } else if (arg == "--fixed-point") {
+            options.fixed_point = true;
+        } else if (arg == "--rational") {
+            options.rational_ratio = true;
+        } else if (arg == "--low-latency") {
+            options.low_latency = true;
+        } else if ((arg == "--passband") && (i + 1 < argc)) {
+            options.passband = std::atof(argv[++i]);
+        } else if ((arg == "--seconds") && (i + 1 < argc)) {
+            options.seconds = std::atof(argv[++i]);
+        } else if ((arg == "--output") && (i + 1 < argc)) {
+            options.output_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((options.passband <= 0.0) || (options.passband >= 1.0) || (options.seconds <= 0.0)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::pair<float, float>> rate_pairs;
+    std::vector<uint16_t> taps;
+    std::vector<uint16_t> filters;
+
+    if (options.quick) {
+        rate_pairs = {{44100, 48000}, {48000, 16000}};
+        taps = {16, 32};
+        filters = {32};
+    } else {
+        rate_pairs = {{44100, 48000}, {48000, 44100}, {22050, 48000}, {32000, 48000},
+                      {16000, 48000}, {48000, 16000}, {96000, 48000}};
+        taps = {8, 16, 32, 64};
+        filters = {16, 32, 64, 128};
+    }
+
+    std::vector<Measurement> measurements;
+
+    for (const auto& pair : rate_pairs) {
+        // The IntegerResampler doesn't use the filter count or subsample interpolation, so one point per tap count. It
+        // has no fixed-point path or low-latency filters, so the ART resampler handles those at every ratio.
+        const bool integer_engine = !options.fixed_point && !options.low_latency &&
+                                    (IntegerResampler::get_factor(pair.first, pair.second) != 0);
+
+        for (uint16_t number_of_taps : taps) {
+            for (uint16_t number_of_filters : filters) {
+                for (int subsample = 0; subsample < 2; ++subsample) {
+                    if (integer_engine && ((number_of_filters != filters[0]) || subsample)) {
+                        continue;
+                    }
+
+                    Measurement measurement = {};
+                    measurement.point = {pair.first, pair.second, number_of_taps, number_of_filters, subsample != 0};
+                    measurement.integer_engine = integer_engine;
+
+                    measure_throughput(measurement.point, options, &measurement);
+                    measure_quality(measurement.point, options, &measurement);
+
+                    std::fprintf(stderr,
+                                 "%6.0f -> %6.0f  %-7s taps %3u filters %3u subsample %d: %8.1fx realtime %8lld bytes"
+                                 "  ripple %6.3f dB  stopband %6.1f dB  THD+N %6.1f dB\n",
+                                 pair.first, pair.second, integer_engine ? "integer" : "art", number_of_taps,
+                                 number_of_filters, subsample, measurement.throughput_fps / pair.first,
+                                 measurement.memory_bytes, measurement.passband_ripple_db,
+                                 measurement.stopband_rejection_db, measurement.thd_n_worst_db);
+
+                    measurements.push_back(measurement);
+                }
+            }
+        }
+    }
+
+    FILE* file = stdout;
+    if (options.output_path != nullptr) {
+        file = std::fopen(options.output_path, "w");
+        if (file == nullptr) {
+            std::fprintf(stderr, "Error: Could not open output file: %s\n", options.output_path);
+            return 1;
+        }
+    }
+
+    write_json(file, measurements, rate_pairs, options);
+
+    if (file != stdout) {
+        std::fclose(file);
+    }
+
+    return 0;
+}
@@ -27,13 +27,35 @@ namespace art_resampler {
     int first_order;            // optimization
   } Biquad;
 
+  // Cascaded biquads applied to every channel of interleaved audio in a single pass, in direct form II: the form of
+  // the esp-dsp dsps_biquad_f32 kernels, which filter each channel on the ESP32 (hosts filter groups of channels with
+  // SSE or NEON instead). The coefficients of each section are laid out as the kernels expect them (b0, b1, b2, a1, a2
+  // in their terms), and each section keeps the two delayed values of its recursion for every channel.
+
+  typedef struct {
+    BiquadCoefficients *coeffs;  // num_sections, in the caller's block
+    int num_sections, num_channels;
+    float *state;                // w0, w1 of each channel of each section, in the caller's state block
+  } BiquadCascade;
+
+#define BIQUAD_CASCADE_STATE_SIZE(sections, channels) (2 * (sections) * (channels))  // floats in the state block
+
   void biquad_init(Biquad * f, const BiquadCoefficients *coeffs, float gain);
+  void biquad_cascade_init(BiquadCascade * f, BiquadCoefficients * coeffs, int num_sections, float *state,
+                           int num_channels);
+  void biquad_cascade_set_section(BiquadCascade * f, int section, const BiquadCoefficients *coeffs);
+  void biquad_cascade_prime(BiquadCascade * f, const float *frame);
 
   void biquad_lowpass(BiquadCoefficients * filter, double frequency);
   void biquad_highpass(BiquadCoefficients * filter, double frequency);
+  void biquad_peaking(BiquadCoefficients * filter, float frequency, float q, float gain_db);
+  void biquad_low_shelf(BiquadCoefficients * filter, float frequency, float q, float gain_db);
+  void biquad_high_shelf(BiquadCoefficients * filter, float frequency, float q, float gain_db);
+  void biquad_notch(BiquadCoefficients * filter, float frequency, float q);
 
   void biquad_apply_buffer(Biquad * f, float *buffer, int num_samples, int stride);
   float biquad_apply_sample(Biquad * f, float input);
+  void biquad_cascade_apply_interleaved(BiquadCascade * f, float *buffer, int num_frames);
 
 }
 }  // namespace esp_audio_libs
\ No newline at end of file
@@ -21,28 +21,61 @@ namespace art_resampler {
 #define SUBSAMPLE_INTERPOLATE 0x1
 #define BLACKMAN_HARRIS 0x2
 #define INCLUDE_LOWPASS 0x4
+#define FIXED_POINT 0x8
+#define LOW_LATENCY 0x10
+
+struct ResampleFilterBank;  // shared, reference-counted sinc filters (see resampleInit())
 
 typedef struct {
   int numChannels, numSamples, numFilters, numTaps, inputIndex, flags;
-  float *tempFilter, outputOffset;
-  float **buffers, **filters;
+  int upFactor, downFactor, outputIndex, outputPhase;  // rational ratio mode only
+  int lookahead;  // taps of the filters after the sinc maximum (half of them, or a quarter with LOW_LATENCY)
+  float *tempFilter;
+  double outputOffset;  // accumulates exactly for the single precision step of any practical ratio
+  union {  // channel-interleaved ring of numSamples frames, followed by a copy of its first numTaps - 1 frames
+    float *history;
+    int32_t *fixedHistory;  // FIXED_POINT contexts, 24-bit samples
+  };
+  union {
+    float **filters;
+    int32_t **fixedFilters;  // FIXED_POINT contexts, Q30 coefficients
+  };
+  ResampleFilterBank *filterBank;  // owner of the filters
+  void *memory;                    // allocation holding the context and history (NULL if provided by the caller)
 } Resample;
 
 typedef struct {
   unsigned int input_used, output_generated;
+  unsigned int clipped;  // samples saturated by the fixed-point process functions
 } ResampleResult;
 
 Resample *resampleInit(int numChannels, int numTaps, int numFilters, float lowpassRatio, int flags);
+Resample *resampleInitRational(int numChannels, int numTaps, int upFactor, int downFactor, float lowpassRatio,
+                               int flags);
+Resample *resampleInitInPlace(void *memory, size_t memorySize, int numChannels, int numTaps, int numFilters,
+                              float lowpassRatio, int flags);
+Resample *resampleInitRationalInPlace(void *memory, size_t memorySize, int numChannels, int numTaps, int upFactor,
+                                      int downFactor, float lowpassRatio, int flags);
+size_t resampleGetContextSize(int numChannels, int numTaps);
+size_t resampleGetFilterBankSize(int numTaps, int numFilters, int upFactor, int flags);
+bool resampleSetFilters(Resample *cxt, int numFilters, float lowpassRatio, int flags);
+bool resampleSetFiltersRational(Resample *cxt, int upFactor, int downFactor, float lowpassRatio, int flags);
 ResampleResult resampleProcess(Resample *cxt, const float *const *input, int numInputFrames, float *const *output,
                                int numOutputFrames, float ratio);
 ResampleResult resampleProcessInterleaved(Resample *cxt, const float *input, int numInputFrames, float *output,
                                           int numOutputFrames, float ratio);
+ResampleResult resampleProcessInterleavedS16(Resample *cxt, const int16_t *input, int numInputFrames,
+                                             int16_t *output, int numOutputFrames, float ratio);
+ResampleResult resampleProcessInterleavedS32(Resample *cxt, const int32_t *input, int numInputFrames,
+                                             int32_t *output, int numOutputFrames, float ratio);
 unsigned int resampleGetRequiredSamples(Resample *cxt, int numOutputFrames, float ratio);
 unsigned int resampleGetExpectedOutput(Resample *cxt, int numInputFrames, float ratio);
 void resampleAdvancePosition(Resample *cxt, float delta);
 float resampleGetPosition(Resample *cxt);
+float resampleGetLatency(Resample *cxt);
 void resampleReset(Resample *cxt);
 void resampleFree(Resample *cxt);
+void resampleFlushFilterCache(void);
 
 }  // namespace art_resampler
 }  // namespace esp_audio_libs
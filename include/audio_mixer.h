@@ -0,0 +1,102 @@
+// Fixed point mixer for several streams of 16-bit audio, with ducking for announcements
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_audio_libs {
+namespace mixer {
+
+// One stream's audio for a call to AudioMixer::mix()
+struct MixerInput {
+  const int16_t *samples;  // first sample of the first frame, or nullptr if the stream has nothing to play
+  uint8_t channels;        // the mixer's channel count, or 1 to play a mono stream on every channel
+  uint8_t stride;          // samples from one frame to the next, or 0 if the frames are packed (stride == channels)
+};
+
+// Scales each stream by its gain with the Q15 esp-dsp kernel (dsps_mulc_s16, which uses SIMD on hosts), a block of
+// frames at a time. When the gains add up to 1 or less, which ducking usually ensures, the sum can't overflow, so the
+// streams are added with dsps_add_s16 (SIMD on the ESP32-S3 and on hosts), which wraps around on overflow. Louder
+// mixes are added up in 32 bits and saturated once, for the output, which is the only step that can clip. The mix is
+// exact to the kernels' rounding, except that a gain above 1 is a Q15 constant and a power-of-two shift, which costs
+// that stream its lowest bits.
+//
+// A stream marked as an announcement ducks the others: while any announcement stream has audio, every other stream is
+// faded down by the ducking depth over the attack time, and faded back up over the release time once they're done.
+// Gain changes ramp too, so neither clicks. Both move in steps of a few frames.
+
+class AudioMixer {
+ public:
+  ~AudioMixer() { this->release(); }
+
+  /// @brief Allocates the mixer with every stream at 0 dB and none ducking, releasing anything from a previous call
+  /// @param streams Number of streams
+  /// @param channels Number of channels in the output
+  /// @param sample_rate Sample rate of the audio, in Hz (sets the length of the ramps)
+  /// @return True if successful, false if an argument is out of range or an allocation failed
+  bool initialize(uint8_t streams, uint8_t channels, float sample_rate);
+
+  /// @brief Frees the mixer
+  void release();
+
+  /// @brief Whether initialize() has succeeded since the last release()
+  bool is_initialized() const { return this->scratch_ != nullptr; }
+
+  /// @brief Sets a stream's gain, ramping to it over the following audio
+  /// @param stream Stream index, from 0
+  /// @param gain_db Gain in dB, up to +24 dB. -INFINITY (or anything below -90 dB) mutes the stream.
+  /// @param ramp_ms Length of the ramp, in milliseconds (0 to change immediately)
+  void set_gain(uint8_t stream, float gain_db, float ramp_ms = 10.0f);
+
+  /// @brief Sets how far and how quickly announcement streams duck the others
+  /// @param depth_db Attenuation while ducked, in dB (negative)
+  /// @param attack_ms Time to fade down to the depth, in milliseconds
+  /// @param release_ms Time to fade back up after the announcements end, in milliseconds
+  void set_ducking(float depth_db, float attack_ms = 20.0f, float release_ms = 300.0f);
+
+  /// @brief Marks whether a stream is an announcement, which ducks the others while it has audio
+  void set_announcement(uint8_t stream, bool announcement);
+
+  /// @brief Mixes the streams into interleaved 16-bit output
+  /// @param inputs One MixerInput per stream
+  /// @param output Pointer to the first sample of the output frames
+  /// @param frames Number of frames
+  /// @param output_stride Samples from one output frame to the next, or 0 if the frames are packed. A stride wider
+  /// than the channel count leaves the other samples of each frame alone, for mixing into a slot of a TDM buffer.
+  /// @return Number of output samples that were clipped
+  uint32_t mix(const MixerInput *inputs, int16_t *output, size_t frames, uint8_t output_stride = 0);
+
+ protected:
+  struct StreamState {
+    float gain;         // current linear gain, before ducking
+    float target_gain;  // linear gain the ramp is heading to
+    float gain_step;    // change in gain per frame while ramping
+    bool announcement;
+  };
+
+  // Advances the gain ramps and the ducking envelope by a number of frames
+  void advance_(size_t frames, bool announcing);
+
+  // Scales one stream's frames by a Q15 constant (up to 32768, a gain of 1) into packed frames of channels_ samples
+  void scale_(const MixerInput &input, size_t frames, int32_t constant, int16_t *destination);
+
+  StreamState *streams_{nullptr};
+  uint8_t stream_count_{0};
+  uint8_t channels_{0};
+  float sample_rate_{0.0f};
+
+  // Ducking envelope, as a linear gain on the streams that aren't announcements
+  float duck_gain_{1.0f};
+  float duck_depth_{0.25f};           // linear gain while fully ducked
+  float duck_attack_factor_{1.0f};    // per-frame factor while fading down
+  float duck_release_factor_{1.0f};   // per-frame factor while fading back up
+
+  // A block of mixed frames, the scaled frames of the stream being added to them, and the 32-bit sum of a loud mix
+  int16_t *scratch_{nullptr};
+  int16_t *scaled_{nullptr};
+  int32_t *sums_{nullptr};
+};
+
+}  // namespace mixer
+}  // namespace esp_audio_libs
@@ -36,6 +36,9 @@ extern "C" {
  * Dot product calculation for two floating point arrays: *dest += (src1[i] * src2[i]); i= [0..N)
  * The extension (_ansi) use ANSI C and could be compiled and run on any platform.
  * The extension (_ae32) is optimized for ESP32 chip.
+ * The extensions (_sse, _avx2, _neon) use SIMD instructions on hosts. They sum with several accumulators, so the
+ * result is rounded differently than _ansi's (by a few ulps of the sum of the absolute products).
+ * The extension (_host) calls the fastest of them that the CPU supports.
  *
  * @param[in] src1  source array 1
  * @param[in] src2  source array 2
@@ -45,6 +48,10 @@ extern "C" {
 esp_err_t dsps_dotprod_f32_ansi(const float *src1, const float *src2, float *dest, int len);
 esp_err_t dsps_dotprod_f32_ae32(const float *src1, const float *src2, float *dest, int len);
 esp_err_t dsps_dotprod_f32_aes3(const float *src1, const float *src2, float *dest, int len);
+esp_err_t dsps_dotprod_f32_sse(const float *src1, const float *src2, float *dest, int len);
+esp_err_t dsps_dotprod_f32_avx2(const float *src1, const float *src2, float *dest, int len);
+esp_err_t dsps_dotprod_f32_neon(const float *src1, const float *src2, float *dest, int len);
+esp_err_t dsps_dotprod_f32_host(const float *src1, const float *src2, float *dest, int len);
 
 /**
  * @brief   multiply constant
@@ -52,6 +59,8 @@ esp_err_t dsps_dotprod_f32_aes3(const float *src1, const float *src2, float *des
  * The function multiplies input array to the constant value
  * x[i*step_out] = y[i*step_in]*C; i=[0..len)
  * The implementation use ANSI C and could be compiled and run on any platform
+ * The extensions (_sse, _avx2, _neon) give the same results as _ansi, using SIMD instructions on hosts when both
+ * steps are 1. The extension (_host) calls the fastest of them that the CPU supports.
  *
  * @param[in] input: input array
  * @param output: output array
@@ -66,6 +75,10 @@ esp_err_t dsps_dotprod_f32_aes3(const float *src1, const float *src2, float *des
  */
 esp_err_t dsps_mulc_s16_ae32(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out);
 esp_err_t dsps_mulc_s16_ansi(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out);
+esp_err_t dsps_mulc_s16_sse(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out);
+esp_err_t dsps_mulc_s16_avx2(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out);
+esp_err_t dsps_mulc_s16_neon(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out);
+esp_err_t dsps_mulc_s16_host(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out);
 
 /**
  * @brief   add two arrays
@@ -73,6 +86,8 @@ esp_err_t dsps_mulc_s16_ansi(const int16_t *input, int16_t *output, int len, int
  * The function add one input array to another
  * out[i*step_out] = input1[i*step1] + input2[i*step2]; i=[0..len)
  * The implementation use ANSI C and could be compiled and run on any platform
+ * The extensions (_sse, _avx2, _neon) give the same results as _ansi, using SIMD instructions on hosts when all the
+ * steps are 1. The extension (_host) calls the fastest of them that the CPU supports.
  *
  * @param[in] input1: input array 1
  * @param[in] input2: input array 2
@@ -92,25 +107,77 @@ esp_err_t dsps_add_s16_ae32(const int16_t *input1, const int16_t *input2, int16_
                             int step2, int step_out, int shift);
 esp_err_t dsps_add_s16_aes3(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1,
                             int step2, int step_out, int shift);
+esp_err_t dsps_add_s16_sse(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1,
+                           int step2, int step_out, int shift);
+esp_err_t dsps_add_s16_avx2(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1,
+                            int step2, int step_out, int shift);
+esp_err_t dsps_add_s16_neon(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1,
+                            int step2, int step_out, int shift);
+esp_err_t dsps_add_s16_host(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1,
+                            int step2, int step_out, int shift);
+
+/**
+ * @brief   IIR filter
+ *
+ * IIR filter 2nd order direct form II (bi quad)
+ * The implementation use ANSI C and could be compiled and run on any platform
+ *
+ * @param[in] input: input array
+ * @param output: output array
+ * @param len: length of input and output vectors
+ * @param coef: array of coefficients. b0,b1,b2,a1,a2
+ *              expected that a0 = 1. b0..b2 - numerator, a0..a2 - denominator
+ * @param w: delay line w0,w1. Length of 2.
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from DSP library
+ */
+esp_err_t dsps_biquad_f32_ansi(const float *input, float *output, int len, float *coef, float *w);
+esp_err_t dsps_biquad_f32_ae32(const float *input, float *output, int len, float *coef, float *w);
+esp_err_t dsps_biquad_f32_aes3(const float *input, float *output, int len, float *coef, float *w);
+
+/**
+ * @brief   name of the SIMD kernels the _host functions call
+ *
+ * The CPU is checked the first time one of the _host functions is called (or this is).
+ *
+ * @return "avx2", "sse", or "neon"
+ */
+const char *dsps_host_backend(void);
 
 #if (dsps_dotprod_f32_aes3_enabled == 1)
 #define dsps_dotprod_f32 dsps_dotprod_f32_aes3
 #elif (dotprod_f32_ae32_enabled == 1)
 #define dsps_dotprod_f32 dsps_dotprod_f32_ae32
+#elif (dsps_host_enabled == 1)
+#define dsps_dotprod_f32 dsps_dotprod_f32_host
 #else
 #define dsps_dotprod_f32 dsps_dotprod_f32_ansi
 #endif  // dsps_dotprod_f32_ae32_enabled
 
 #if (dsps_mulc_s16_ae32_enabled == 1)
 #define dsps_mulc_s16 dsps_mulc_s16_ae32
+#elif (dsps_host_enabled == 1)
+#define dsps_mulc_s16 dsps_mulc_s16_host
 #else
 #define dsps_mulc_s16 dsps_mulc_s16_ansi
 #endif  // dsps_mulc_s16_ae32_enabled
 
+#if (dsps_biquad_f32_aes3_enabled == 1)
+#define dsps_biquad_f32 dsps_biquad_f32_aes3
+#elif (dsps_biquad_f32_ae32_enabled == 1)
+#define dsps_biquad_f32 dsps_biquad_f32_ae32
+#else
+#define dsps_biquad_f32 dsps_biquad_f32_ansi
+#endif  // dsps_biquad_f32_aes3_enabled
+
 #if (dsps_add_s16_aes3_enabled == 1)
 #define dsps_add_s16 dsps_add_s16_aes3
 #elif (dsps_add_s16_ae32_enabled == 1)
 #define dsps_add_s16 dsps_add_s16_ae32
+#elif (dsps_host_enabled == 1)
+#define dsps_add_s16 dsps_add_s16_host
 #else
 #define dsps_add_s16 dsps_add_s16_ansi
 #endif  // dsps_add_s16_aes3_enabled
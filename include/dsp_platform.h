@@ -14,6 +14,7 @@
 #define dotprod_f32_ae32_enabled 1
 #define dotprode_f32_ae32_enabled 1
 #define dsps_add_s16_ae32_enabled 1
+#define dsps_biquad_f32_ae32_enabled 1
 
 #endif  //
 
@@ -28,6 +29,35 @@
 #if CONFIG_IDF_TARGET_ESP32S3
 #define dsps_dotprod_f32_aes3_enabled 1
 #define dsps_add_s16_aes3_enabled 1
+#define dsps_biquad_f32_aes3_enabled 1
 #endif
 
+// Hosts: SSE2 (with AVX2 and FMA chosen at run time when the CPU has them) on x86, and NEON on ARM. The kernels need
+// GCC or Clang for the target attributes and the CPU feature checks. The NEON kernels, and the NEON paths of the ART
+// resampler and biquads, haven't been built or checked on ARM yet, so they're only used when DSP_HOST_NEON is defined.
+// Other ARM hosts use the ANSI C kernels and the generic loops.
+#if !defined(ESP_PLATFORM) && defined(__GNUC__)
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+
+#define dsps_dotprod_f32_sse_enabled 1
+#define dsps_dotprod_f32_avx2_enabled 1
+#define dsps_add_s16_sse_enabled 1
+#define dsps_add_s16_avx2_enabled 1
+#define dsps_mulc_s16_sse_enabled 1
+#define dsps_mulc_s16_avx2_enabled 1
+#define dsps_host_enabled 1
+
+#elif defined(__ARM_NEON) && defined(DSP_HOST_NEON)
+
+#define dsps_host_neon_enabled 1
+#define dsps_dotprod_f32_neon_enabled 1
+#define dsps_add_s16_neon_enabled 1
+#define dsps_mulc_s16_neon_enabled 1
+#define dsps_host_enabled 1
+
+#endif
+
+#endif  // !ESP_PLATFORM && __GNUC__
+
 #endif  // _dsp_platform_H_
\ No newline at end of file
@@ -0,0 +1,123 @@
+// Gain stage with smooth per-sample ramps for volume changes, muting, and fades
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_audio_libs {
+namespace gain {
+
+// How the gain moves from one value to the next
+enum GainRampShape : uint8_t {
+  GAIN_RAMP_LINEAR = 0,   // the same change in linear gain every frame
+  GAIN_RAMP_EXPONENTIAL,  // the same change in dB every frame, which sounds even across the whole ramp
+};
+
+// Applies a gain to interleaved audio, moving it a little every frame when it changes, instead of jumping once per
+// buffer, which is heard as zipper noise. Muting and fades are ramps to and from silence that leave the volume setting
+// alone. Exponential ramps to or from silence run to -80 dB and jump the rest of the way, which isn't audible.
+//
+// The gain can be applied on its own, to float or Q15 samples, or while converting formats (see the overloads taking a
+// GainRamp in quantization_utils.h), so it never needs a pass over the audio of its own. A steady gain of 1 skips the
+// work entirely.
+
+class GainRamp {
+ public:
+  /// @brief Sets the stage to a steady gain, unmuted
+  /// @param channels Number of interleaved channels
+  /// @param sample_rate Sample rate of the audio, in Hz (sets the length of the ramps)
+  /// @param gain_db Initial gain, in dB
+  void initialize(uint8_t channels, float sample_rate, float gain_db = 0.0f);
+
+  /// @brief Changes the volume, ramping to it (unless muted, when it takes effect on unmuting)
+  /// @param gain_db Gain in dB, up to +42 dB. -INFINITY (or anything below -120 dB) is silence.
+  /// @param ramp_ms Length of the ramp, in milliseconds (0 to change immediately)
+  /// @param shape How the gain moves during the ramp
+  void set_gain(float gain_db, float ramp_ms = 20.0f, GainRampShape shape = GAIN_RAMP_EXPONENTIAL);
+
+  /// @brief Ramps to silence or back to the volume
+  void set_muted(bool muted, float ramp_ms = 10.0f, GainRampShape shape = GAIN_RAMP_EXPONENTIAL);
+
+  /// @brief Starts from silence and ramps up to the volume, unmuting, such as at the start of a stream
+  void fade_in(float ramp_ms, GainRampShape shape = GAIN_RAMP_EXPONENTIAL);
+
+  /// @brief Ramps down to silence and stays muted, such as before stopping a stream
+  void fade_out(float ramp_ms, GainRampShape shape = GAIN_RAMP_EXPONENTIAL);
+
+  /// @brief Whether the stage is muted (or faded out), even if it's still ramping down
+  bool is_muted() const { return this->muted_; }
+
+  /// @brief Whether the gain is still moving
+  bool is_ramping() const { return this->remaining_ > 0; }
+
+  /// @brief Whether the output is silent and will stay that way until the gain changes
+  bool is_silent() const { return !this->is_ramping() && (this->gain_ == 0.0f); }
+
+  /// @brief The current linear gain
+  float get_gain() const { return this->gain_; }
+
+  /// @brief Number of interleaved channels
+  uint8_t channels() const { return this->channels_; }
+
+  /// @brief Applies the gain to interleaved float samples in place
+  /// @param buffer Pointer to the frames
+  /// @param frames Number of frames
+  void process(float *buffer, size_t frames);
+
+  /// @brief Applies the gain to interleaved Q15 samples in place, truncating like dsps_mulc_s16 and saturating
+  /// @param buffer Pointer to the frames
+  /// @param frames Number of frames
+  /// @return Number of clipped samples
+  uint32_t process(int16_t *buffer, size_t frames);
+
+  /// @brief Calls frame(index, gain) for each of a number of frames with the gain for it, advancing the ramp. This is
+  /// how the gain is fused into other loops over the audio.
+  template<typename Frame> void for_each_frame(size_t frames, Frame frame);
+
+ protected:
+  // Starts a ramp from the current gain to the target over ramp_ms
+  void start_ramp_(float target, float ramp_ms, GainRampShape shape);
+
+  uint8_t channels_{1};
+  float sample_rate_{48000.0f};
+  float volume_{1.0f};  // linear gain set by set_gain(), which muting doesn't change
+  bool muted_{false};
+
+  float gain_{1.0f};         // gain for the next frame
+  float target_gain_{1.0f};  // gain at the end of the ramp
+  float step_{0.0f};         // change per frame: added for a linear ramp, multiplied for an exponential one
+  size_t remaining_{0};      // frames left in the ramp
+  GainRampShape shape_{GAIN_RAMP_LINEAR};
+};
+
+template<typename Frame> void GainRamp::for_each_frame(size_t frames, Frame frame) {
+  size_t index = 0;
+
+  if (this->remaining_ > 0) {
+    const size_t count = (frames < this->remaining_) ? frames : this->remaining_;
+    float gain = this->gain_;
+
+    if (this->shape_ == GAIN_RAMP_LINEAR) {
+      for (; index < count; ++index, gain += this->step_) {
+        frame(index, gain);
+      }
+    } else {
+      for (; index < count; ++index, gain *= this->step_) {
+        frame(index, gain);
+      }
+    }
+
+    // Land exactly on the target, whatever rounding built up along the way
+    this->remaining_ -= count;
+    this->gain_ = (this->remaining_ > 0) ? gain : this->target_gain_;
+  }
+
+  const float gain = this->gain_;
+  for (; index < frames; ++index) {
+    frame(index, gain);
+  }
+}
+
+}  // namespace gain
+}  // namespace esp_audio_libs
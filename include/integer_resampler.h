@@ -0,0 +1,132 @@
+// Cascaded polyphase FIR resampler for small integer ratios
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_audio_libs {
+namespace resampler {
+
+// Resamples interleaved floating point audio up or down by a factor of 2, 3, 4, or 6 with a cascade of polyphase
+// Nyquist filter stages: half-band stages for each factor of 2 and a third-band stage for a factor of 3. Every M-th tap
+// of a Nyquist(M) filter is zero except the center one and the taps are symmetrical, so a decimating stage needs about
+// 1 / (2M) of the multiplies of a plain FIR of the same length, and an interpolating stage copies the input samples for
+// one of its M phases and shares the multiplies of mirrored phases. The first stage of a decimator (the last of an
+// interpolator) runs at the highest rate but only has to keep aliases out of the final band, so it's kept short.
+//
+// Like the Resampler wrapping the ART resampler, the output starts aligned with the input (the filter delay is
+// skipped over), and the input is consumed only as far as the output space allows.
+
+class IntegerResampler {
+ public:
+  ~IntegerResampler() { this->release(); }
+
+  /// @brief Returns the factor between the rates if they're an integer multiple that can be handled, 0 otherwise
+  /// @param source_sample_rate Input sample rate
+  /// @param target_sample_rate Output sample rate
+  /// @return 2, 3, 4, or 6 for either direction, or 0 if the ratio isn't supported
+  static uint32_t get_factor(float source_sample_rate, float target_sample_rate);
+
+  /// @brief Returns the number of bytes initialize() allocates for a configuration
+  /// @param source_sample_rate Input sample rate
+  /// @param target_sample_rate Output sample rate
+  /// @param channels Number of interleaved channels
+  /// @param number_of_taps Tap count of the ART resampler to match, as for initialize()
+  /// @return Size in bytes, or 0 if the ratio isn't supported
+  static size_t get_memory_size(float source_sample_rate, float target_sample_rate, uint8_t channels,
+                                uint16_t number_of_taps);
+
+  /// @brief Returns the filter multiplies per output frame of each channel, for estimating the processing cost
+  /// @param source_sample_rate Input sample rate
+  /// @param target_sample_rate Output sample rate
+  /// @param number_of_taps Tap count of the ART resampler to match, as for initialize()
+  /// @return Average multiplies per output frame, or 0 if the ratio isn't supported
+  static float get_multiplies_per_frame(float source_sample_rate, float target_sample_rate, uint16_t number_of_taps);
+
+  /// @brief Allocates the filters and sample histories, releasing anything from a previous call
+  /// @param source_sample_rate Input sample rate
+  /// @param target_sample_rate Output sample rate, a supported factor (see get_factor()) from the input rate
+  /// @param channels Number of interleaved channels
+  /// @param number_of_taps Tap count of the ART resampler whose rejection the final stage matches; it's usually longer
+  /// @return True if successful, false if the ratio isn't supported or the allocation failed
+  bool initialize(float source_sample_rate, float target_sample_rate, uint8_t channels, uint16_t number_of_taps);
+
+  /// @brief Frees the filters and sample histories
+  void release();
+
+  /// @brief Number of input frames that produce exactly the given number of output frames
+  size_t required_input(size_t output_frames) const;
+
+  /// @brief Resamples interleaved input frames, consuming them until they run out or the output space is full
+  /// @param input Pointer to the input frames
+  /// @param input_frames Number of frames available at the input pointer
+  /// @param output Pointer to write the output frames to
+  /// @param output_frames Number of frames free at the output pointer
+  /// @param frames_used Set to the number of input frames consumed
+  /// @param frames_generated Set to the number of output frames written
+  void process(const float *input, size_t input_frames, float *output, size_t output_frames, size_t *frames_used,
+               size_t *frames_generated);
+
+  /// @brief Signal delay of the filters at low frequencies, in output frames (see Resampler::latency_frames())
+  float latency_frames() const;
+
+ protected:
+  // One Nyquist(factor) FIR stage. The filter spans half_width samples at the lower rate on each side of its center.
+  struct Stage {
+    uint8_t factor{0};
+    bool interpolate{false};
+    uint16_t half_width{0};
+
+    // Decimating: coefficients of the symmetrical tap pairs around the center, and where the older and then the
+    // newer tap of each pair starts in the phases. Interpolating: the first half of phase 1 for a factor of 2, or the
+    // even and odd parts of phase 1 (each half_width long) for a factor of 3, whose phase 2 is phase 1 reversed.
+    float *coefficients{nullptr};
+    uint16_t *offsets{nullptr};
+    float *phases{nullptr};  // decimating: per channel, the windows of a block split into factor phases
+    uint16_t pairs{0};
+
+    // Interleaved sample history holding the filter window and a block of new frames; the last window_frames - 1
+    // frames are moved back to the start when it fills up
+    float *history{nullptr};
+    size_t window_frames{0};
+    size_t history_frames{0};
+    size_t fill{0};
+
+    // Decimating: inputs since the last output (negative until the first window is centered on the first input).
+    // Interpolating: phase of the next output, which is taken from the pending group of factor frames unless it's 0.
+    int phase{0};
+    size_t prime{0};  // inputs still needed before the first output (interpolating)
+    float *pending{nullptr};
+    float *accumulator{nullptr};  // sums of the even and odd parts of phase 1 for a block of inputs (interpolating)
+  };
+
+  bool initialize_stage_(Stage *stage, uint8_t factor, bool interpolate, uint16_t half_width);
+  static size_t stage_required_input_(const Stage *stage, size_t output_frames);
+
+  // Appends frames to a stage's history, first moving the window back to the start if they don't fit
+  void push_frames_(Stage *stage, const float *input, size_t frames);
+
+  void run_stage_(Stage *stage, const float *input, size_t input_frames, float *output, size_t output_frames,
+                  size_t *frames_used, size_t *frames_generated);
+  void decimate_stage_(Stage *stage, const float *input, size_t input_frames, float *output, size_t output_frames,
+                       size_t *frames_used, size_t *frames_generated);
+  void interpolate_stage_(Stage *stage, const float *input, size_t input_frames, float *output, size_t output_frames,
+                          size_t *frames_used, size_t *frames_generated);
+
+  // Computes all factor phases for the windows ending at each of the last groups frames pushed
+  void interpolate_groups_(Stage *stage, size_t groups, float *output);
+
+  // Stages in processing order, and scratch frames between them
+  Stage stages_[2];
+  uint8_t stage_count_{0};
+  float *scratch_{nullptr};
+  size_t scratch_frames_{0};
+
+  uint32_t factor_{0};
+  bool interpolate_{false};
+  uint8_t channels_{0};
+};
+
+}  // namespace resampler
+}  // namespace esp_audio_libs
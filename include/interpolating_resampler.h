@@ -0,0 +1,79 @@
+// Low-cost linear or cubic interpolation resampler for low-fidelity sources
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_audio_libs {
+namespace resampler {
+
+// How the Resampler computes output samples between input samples
+enum InterpolationMode : uint8_t {
+  INTERPOLATION_SINC = 0,  // windowed sinc filters (the ART resampler or IntegerResampler)
+  INTERPOLATION_LINEAR,    // straight line between the two nearest input samples
+  INTERPOLATION_CUBIC,     // Catmull-Rom (cubic Hermite) spline through the four nearest input samples
+};
+
+// Resamples interleaved floating point audio at any ratio by interpolating between neighboring input samples. There's
+// no filtering, so images and aliases are only attenuated by the interpolation itself (a few tens of dB at best), but
+// each output sample costs a handful of multiplies per channel. It's meant for UI sounds, voice prompts, and other
+// sources where that's acceptable; the Resampler can add a biquad lowpass to help.
+//
+// Like the other engines the output starts aligned with the input, the input is consumed only as far as the output
+// space allows, and the ratio may change on every call (for ASRC).
+
+class InterpolatingResampler {
+ public:
+  ~InterpolatingResampler() { this->release(); }
+
+  /// @brief Allocates the sample history, releasing anything from a previous call
+  /// @param channels Number of interleaved channels
+  /// @param mode INTERPOLATION_LINEAR or INTERPOLATION_CUBIC
+  /// @return True if successful, false if the mode isn't supported or the allocation failed
+  bool initialize(uint8_t channels, InterpolationMode mode);
+
+  /// @brief Frees the sample history
+  void release();
+
+  /// @brief Whether initialize() has succeeded since the last release()
+  bool is_initialized() const { return this->history_ != nullptr; }
+
+  /// @brief Number of input frames that produce exactly the given number of output frames at the given ratio
+  size_t required_input(size_t output_frames, float ratio) const;
+
+  /// @brief Resamples interleaved input frames, consuming them until they run out or the output space is full
+  /// @param input Pointer to the input frames
+  /// @param input_frames Number of frames available at the input pointer
+  /// @param output Pointer to write the output frames to
+  /// @param output_frames Number of frames free at the output pointer
+  /// @param ratio Output rate divided by the input rate
+  /// @param frames_used Set to the number of input frames consumed
+  /// @param frames_generated Set to the number of output frames written
+  void process(const float *input, size_t input_frames, float *output, size_t output_frames, float ratio,
+               size_t *frames_used, size_t *frames_generated);
+
+  /// @brief Average signal delay, in input frames (see Resampler::latency_frames())
+  float latency_frames() const { return this->taps_ / 2 - 0.5f; }
+
+ protected:
+  // Returns the taps_ consecutive frames starting at virtual frame index, gathering them into window_ if any of them
+  // are still in the history
+  const float *window_(const float *input, size_t index);
+
+  // The last taps_ frames consumed (oldest first), which come before the first input frame of the next call. With the
+  // input, they form a sequence of virtual frames: index i < taps_ is history_ frame i, and the rest are input frame
+  // i - taps_.
+  float *history_{nullptr};
+  float *window_frames_{nullptr};
+
+  // Virtual frame index of the first tap of the next output sample plus its fraction, in fixed point (see
+  // POSITION_BITS). The output falls between taps taps_ / 2 - 1 and taps_ / 2.
+  uint64_t position_{0};
+
+  uint8_t taps_{0};  // 2 for linear interpolation, 4 for cubic
+  uint8_t channels_{0};
+};
+
+}  // namespace resampler
+}  // namespace esp_audio_libs
@@ -0,0 +1,55 @@
+// Splits offline resampling of whole recordings across threads (host builds only)
+
+#pragma once
+
+#include "resampler.h"
+
+namespace esp_audio_libs {
+namespace resampler {
+
+// Resamples a complete recording held in memory on several threads, with output that's bit-identical to a Resampler
+// initialized with the same configuration and given the same buffers in one resample() call. Only the filter history
+// carries from one output sample to the next, so the output is split into chunks that are computed independently:
+// each chunk's resampler starts a little before it on the input to fill its history, and is positioned exactly on
+// the phase of the chunk's first output sample. The sample conversions run in parallel too, while the optional
+// pre/post biquad (whose state never settles exactly) runs over the whole recording on the calling thread.
+//
+// The ART resampler (with a fractional or rational ratio) and the IntegerResampler are split this way, and matching
+// rates are converted in parallel. Fixed point, ASRC, and the interpolation modes are resampled serially.
+//
+// The input and output are held as floating point samples while resampling, which takes 4 bytes per sample of each.
+// It's built for the standalone (host) library only, not for ESP-IDF.
+
+class ParallelResampler {
+ public:
+  /// @brief Sets the number of threads to split the work across
+  /// @param threads Number of threads, including the calling one (0 for the number of hardware threads)
+  explicit ParallelResampler(size_t threads = 0);
+
+  /// @brief Checks and stores the configuration used for every following resample call
+  /// @param config ResamplerConfiguration, as for Resampler::initialize()
+  /// @return True if a Resampler could be initialized with it, false otherwise
+  bool initialize(ResamplerConfiguration &config);
+
+  /// @brief Resamples a whole recording, starting from a silent history as a newly initialized Resampler does
+  /// @param input_buffer Pointer to the source samples
+  /// @param output_buffer Pointer to write the resampled samples to
+  /// @param input_frames_available Frames available at the input source pointer
+  /// @param output_frames_free Frames free at the output sink pointer
+  /// @param gain_db Gain (in dB) to apply before resampling
+  /// @return (ResamplerResults) The same results as a single Resampler::resample() call with these arguments (if the
+  /// float buffers can't be allocated, it's resampled serially)
+  ResamplerResults resample(const uint8_t *input_buffer, uint8_t *output_buffer, size_t input_frames_available,
+                            size_t output_frames_free, float gain_db);
+
+  /// @brief Number of threads the work is split across
+  size_t threads() const { return this->threads_; }
+
+ protected:
+  ResamplerConfiguration config_{};
+  bool initialized_{false};
+  size_t threads_;
+};
+
+}  // namespace resampler
+}  // namespace esp_audio_libs
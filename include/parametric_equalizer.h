@@ -0,0 +1,106 @@
+// N-band parametric equalizer for interleaved floating point audio
+
+#pragma once
+
+#include "art_biquad.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_audio_libs {
+namespace equalizer {
+
+// What a band does to the spectrum
+enum EqualizerBandType : uint8_t {
+  EQUALIZER_BAND_OFF = 0,     // passes the audio unchanged
+  EQUALIZER_BAND_PEAKING,     // boosts or cuts around the frequency (a bell)
+  EQUALIZER_BAND_LOW_SHELF,   // boosts or cuts below the frequency
+  EQUALIZER_BAND_HIGH_SHELF,  // boosts or cuts above the frequency
+  EQUALIZER_BAND_NOTCH,       // removes the frequency (the gain is ignored)
+};
+
+struct EqualizerBand {
+  EqualizerBandType type;
+  float frequency;  // center frequency (peaking, notch) or corner frequency (shelves), in Hz
+  float q;          // bandwidth, or the slope of a shelf (0.707 is the steepest without overshoot)
+  float gain_db;    // boost (positive) or cut (negative)
+};
+
+// Filters every channel through a cascade of biquads, one per band, in a single pass over the buffer (see
+// art_resampler::BiquadCascade, which uses the esp-dsp kernels on the ESP32 and SSE or NEON on hosts). Every band is
+// a section of the cascade whether it's in use or not, so the cost follows the number of bands it's initialized with:
+// about five multiplies per band per sample.
+//
+// Changing a band doesn't switch the filters abruptly, which would click. The new filters run alongside the old ones,
+// starting from their state, and the output crossfades from one to the other over a few milliseconds. Changes made
+// during a crossfade are gathered up and start the next one as soon as it finishes, so a control can be swept freely.
+
+class ParametricEqualizer {
+ public:
+  ~ParametricEqualizer() { this->release(); }
+
+  /// @brief Allocates the filters with every band off, releasing anything from a previous call
+  /// @param channels Number of interleaved channels
+  /// @param sample_rate Sample rate of the audio, in Hz
+  /// @param bands Number of bands
+  /// @param fade_ms Length of the crossfade when a band changes, in milliseconds (0 to switch immediately)
+  /// @return True if successful, false if an argument is out of range or an allocation failed
+  bool initialize(uint8_t channels, float sample_rate, uint8_t bands, float fade_ms = 10.0f);
+
+  /// @brief Frees the filters
+  void release();
+
+  /// @brief Whether initialize() has succeeded since the last release()
+  bool is_initialized() const { return this->state_[0] != nullptr; }
+
+  /// @brief Changes a band, crossfading to it over the following audio
+  /// @param index Band index, from 0
+  /// @param band New settings
+  /// @return True if successful, false if the index or the frequency is out of range or the Q isn't positive
+  bool set_band(uint8_t index, const EqualizerBand &band);
+
+  /// @brief The settings of a band, including any change still waiting for a crossfade
+  const EqualizerBand &get_band(uint8_t index) const { return this->bands_[index]; }
+
+  /// @brief Number of bands
+  uint8_t bands() const { return this->band_count_; }
+
+  /// @brief Whether the output is still crossfading to changed bands
+  bool is_fading() const { return this->fade_position_ < this->fade_frames_; }
+
+  /// @brief Clears the filter history, as if the audio had been silent, and applies any change immediately
+  void reset();
+
+  /// @brief Equalizes interleaved audio in place
+  /// @param buffer Pointer to the frames
+  /// @param frames Number of frames
+  void process(float *buffer, size_t frames);
+
+ protected:
+  // Computes the coefficients of every band into the given array
+  void design_(art_resampler::BiquadCoefficients *coeffs) const;
+
+  // Starts crossfading from the current filters to ones designed from the bands
+  void start_fade_();
+
+  EqualizerBand *bands_{nullptr};
+  uint8_t band_count_{0};
+  uint8_t channels_{0};
+  float sample_rate_{0.0f};
+
+  // The current filters ([current_]) and, while crossfading, the new ones, with their coefficients and state
+  art_resampler::BiquadCascade cascades_[2]{};
+  art_resampler::BiquadCoefficients *coeffs_[2]{nullptr, nullptr};
+  float *state_[2]{nullptr, nullptr};
+  uint8_t current_{0};
+
+  // The new filters' output for a block of frames while crossfading
+  float *fade_buffer_{nullptr};
+
+  size_t fade_frames_{0};     // crossfade length (0 to switch immediately)
+  size_t fade_position_{0};   // frames of the crossfade done, fade_frames_ when there isn't one
+  bool changed_{false};       // the bands changed since the current crossfade started
+};
+
+}  // namespace equalizer
+}  // namespace esp_audio_libs
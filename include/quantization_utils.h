@@ -4,6 +4,11 @@
 #include <stdint.h>
 
 namespace esp_audio_libs {
+
+namespace gain {
+class GainRamp;
+}  // namespace gain
+
 namespace quantization_utils {
 
 /// @brief Converts an array of quantized samples with the specified number of bits into floating point samples.
@@ -24,5 +29,86 @@ void quantized_to_float(const uint8_t *input_buffer, float *output_buffer, uint3
 uint32_t float_to_quantized(const float *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
                             uint8_t output_bits);
 
+/// @brief Converts an array of quantized samples with the specified number of bits into 16-bit fixed point samples.
+/// @param input_buffer Pointer to the input quantized samples aligned to the byte
+/// @param output_buffer Pointer to the output 16-bit samples
+/// @param num_samples Number of samples to convert
+/// @param input_bits Number of bits per sample for the quantized samples
+/// @param gain_db Optional amount of gain (in dB) to apply when converting. Results are saturated.
+/// @return Number of clipped samples
+uint32_t quantized_to_fixed16(const uint8_t *input_buffer, int16_t *output_buffer, uint32_t num_samples,
+                              uint8_t input_bits, float gain_db);
+
+/// @brief Converts an array of quantized samples with the specified number of bits into 32-bit fixed point samples.
+/// @param input_buffer Pointer to the input quantized samples aligned to the byte
+/// @param output_buffer Pointer to the output 32-bit samples
+/// @param num_samples Number of samples to convert
+/// @param input_bits Number of bits per sample for the quantized samples
+/// @param gain_db Optional amount of gain (in dB) to apply when converting. Results are saturated.
+/// @return Number of clipped samples
+uint32_t quantized_to_fixed32(const uint8_t *input_buffer, int32_t *output_buffer, uint32_t num_samples,
+                              uint8_t input_bits, float gain_db);
+
+/// @brief Converts an array of 16-bit fixed point samples into quantized samples with the specified number of bits.
+/// @param input_buffer Pointer to the input 16-bit samples
+/// @param output_buffer Pointer to the output quantized samples. Samples will be aligned to the byte.
+/// @param num_samples Number of samples to convert
+/// @param output_bits Number of bits per sample for the quantized samples
+/// @return Number of clipped samples
+uint32_t fixed16_to_quantized(const int16_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                              uint8_t output_bits);
+
+/// @brief Converts an array of 32-bit fixed point samples into quantized samples with the specified number of bits.
+/// @param input_buffer Pointer to the input 32-bit samples
+/// @param output_buffer Pointer to the output quantized samples. Samples will be aligned to the byte.
+/// @param num_samples Number of samples to convert
+/// @param output_bits Number of bits per sample for the quantized samples
+/// @return Number of clipped samples
+uint32_t fixed32_to_quantized(const int32_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                              uint8_t output_bits);
+
+/// @brief Converts an array of quantized samples directly into quantized samples with a different number of bits (or
+/// the same number, to apply gain), without converting to floating point. Samples are rounded when narrowing.
+/// @param input_buffer Pointer to the input quantized samples aligned to the byte
+/// @param output_buffer Pointer to the output quantized samples. Samples will be aligned to the byte.
+/// @param num_samples Number of samples to convert
+/// @param input_bits Number of bits per sample for the input samples
+/// @param output_bits Number of bits per sample for the output samples
+/// @param gain_db Optional amount of gain (in dB) to apply when converting. Results are saturated.
+/// @return Number of clipped samples
+uint32_t quantized_to_quantized(const uint8_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                                uint8_t input_bits, uint8_t output_bits, float gain_db);
+
+/// @brief Converts interleaved quantized frames into floating point samples, applying a gain ramp in the same pass.
+/// @param input_buffer Pointer to the input quantized samples aligned to the byte
+/// @param output_buffer Pointer to the output floating point samples
+/// @param num_frames Number of frames to convert, each of ramp.channels() samples
+/// @param input_bits Number of bits per sample for the quantized samples
+/// @param ramp Gain stage, which is advanced by the frames. There is no verification for clipping.
+void quantized_to_float(const uint8_t *input_buffer, float *output_buffer, uint32_t num_frames, uint8_t input_bits,
+                        gain::GainRamp &ramp);
+
+/// @brief Converts interleaved quantized frames into 16-bit fixed point samples, applying a gain ramp in the same pass.
+/// @param input_buffer Pointer to the input quantized samples aligned to the byte
+/// @param output_buffer Pointer to the output 16-bit samples
+/// @param num_frames Number of frames to convert, each of ramp.channels() samples
+/// @param input_bits Number of bits per sample for the quantized samples
+/// @param ramp Gain stage, which is advanced by the frames. Results are saturated.
+/// @return Number of clipped samples
+uint32_t quantized_to_fixed16(const uint8_t *input_buffer, int16_t *output_buffer, uint32_t num_frames,
+                              uint8_t input_bits, gain::GainRamp &ramp);
+
+/// @brief Converts interleaved quantized frames into quantized samples with a different number of bits (or the same
+/// number), applying a gain ramp in the same pass. Samples are rounded when narrowing.
+/// @param input_buffer Pointer to the input quantized samples aligned to the byte
+/// @param output_buffer Pointer to the output quantized samples. Samples will be aligned to the byte.
+/// @param num_frames Number of frames to convert, each of ramp.channels() samples
+/// @param input_bits Number of bits per sample for the input samples
+/// @param output_bits Number of bits per sample for the output samples
+/// @param ramp Gain stage, which is advanced by the frames. Results are saturated.
+/// @return Number of clipped samples
+uint32_t quantized_to_quantized(const uint8_t *input_buffer, uint8_t *output_buffer, uint32_t num_frames,
+                                uint8_t input_bits, uint8_t output_bits, gain::GainRamp &ramp);
+
 }  // namespace quantization_utils
 }  // namespace esp_audio_libs
@@ -4,6 +4,8 @@
 
 #include "art_biquad.h"
 #include "art_resampler.h"
+#include "integer_resampler.h"
+#include "interpolating_resampler.h"
 
 #include <algorithm>
 
@@ -29,6 +31,14 @@ struct ResamplerConfiguration {
   bool subsample_interpolate;
   uint16_t number_of_taps;
   uint16_t number_of_filters;
+  bool use_rational_ratio;      // exact integer phase stepping with one filter per phase, if the rates allow it
+  bool use_fixed_point;         // integer-only processing for chips with a slow FPU (pre/post filters aren't used)
+  bool use_asrc;                // trim the ratio to hold the sink buffer level reported with update_buffer_level()
+  uint32_t asrc_target_frames;  // sink buffer level (in frames) the ASRC loop holds
+  uint16_t asrc_max_ppm;        // largest ratio trim the ASRC loop applies (0 for 1000 ppm)
+  uint16_t asrc_response_ms;    // ASRC loop time constant (0 for 2000 ms)
+  bool use_low_latency;         // asymmetrical filters with half the delay but poorer response (see latency_frames())
+  uint8_t interpolation_mode;   // InterpolationMode: cheap linear or cubic interpolation instead of the sinc filters
 };
 
 class Resampler {
@@ -37,12 +47,36 @@ class Resampler {
       : input_buffer_samples_(input_buffer_samples), output_buffer_samples_(output_buffer_samples) {}
   ~Resampler();
 
-  /// @brief Initializes the resampler
+  /// @brief Initializes the resampler. Rates that differ by a factor of 2, 3, 4, or 6 use the cascaded half-band
+  /// IntegerResampler instead of the ART resampler (the pre/post filter isn't needed then), unless fixed point, ASRC,
+  /// or low latency is configured. With a linear or cubic interpolation_mode, the InterpolatingResampler is used at
+  /// any ratio instead (with ASRC too, but not with fixed point), and the pre/post filter is a single biquad.
   /// @param config ResamplerConfiguration
-  /// @return True if buffers were allocated succesfully, false otherwise.
+  /// @return True if buffers were allocated succesfully, false otherwise. May be called again to start over with a
+  /// new configuration (anything allocated by the previous call is released first).
   bool initialize(ResamplerConfiguration &config);
 
-  /// @brief Resamples the input samples to the initalized sample rate
+  /// @brief Changes the configuration of an initialized resampler mid-stream, keeping its sample history so the
+  /// transition is gapless (e.g., on a track change between 44.1 kHz and 48 kHz content). The ratio, lowpass, and
+  /// optional filters switch before the next resample call. Filters are reused from the shared cache when possible, so
+  /// switching between configurations that have both been used before doesn't allocate. Call it between resample
+  /// calls only.
+  /// @param config ResamplerConfiguration; the channels, number of taps, low-latency setting, interpolation mode, and
+  /// fixed-point setting (including whether the fixed-point samples fit in 16 bits) must match the initialized
+  /// configuration. If
+  /// initialize() chose the IntegerResampler, the rates can't change either.
+  /// @return True if the resampler was reconfigured, false if the configuration is incompatible (initialize() must be
+  /// used instead) or the new filters couldn't be allocated, in which case the previous configuration is kept.
+  bool reconfigure(ResamplerConfiguration &config);
+
+  /// @brief Changes only the source and target sample rates, as reconfigure() does with the current configuration
+  /// @param source_sample_rate New input sample rate
+  /// @param target_sample_rate New output sample rate
+  /// @return True if successful, false otherwise
+  bool set_ratio(float source_sample_rate, float target_sample_rate);
+
+  /// @brief Resamples the input samples to the initalized sample rate. When the rates match (and ASRC isn't used) the
+  /// samples are converted directly between the integer formats, without any floating point.
   /// @param input Pointer to source samples as a uint8_t buffer
   /// @param output Pointer to write resampled samples as a uint8_t buffer
   /// @param input_frames_available Frames available at the input source pointer
@@ -52,17 +86,72 @@ class Resampler {
   ResamplerResults resample(const uint8_t *input_buffer, uint8_t *output_buffer, size_t input_frames_available,
                             size_t output_frames_free, float gain_db);
 
+  /// @brief Reports the fill level of the buffer the output is written to, for the ASRC control loop. The ratio is
+  /// trimmed so the level settles at the configured target, compensating for drift between the source and sink
+  /// clocks. Call it regularly (e.g., after every resample call); it has no effect unless use_asrc is configured.
+  /// @param buffered_frames Frames currently waiting in the sink buffer
+  void update_buffer_level(size_t buffered_frames);
+
+  /// @brief Current ASRC trim of the sample ratio, in parts per million (positive when producing more output)
+  float ratio_trim_ppm() const { return this->asrc_trim_ * 1e6f; }
+
+  /// @brief Signal delay added by the resampler and its optional filters at low frequencies, in output frames, i.e.
+  /// how far the output generated so far lags the input consumed so far. It's zero when the rates match and the
+  /// samples are only converted.
+  /// @return Group delay at DC, in output frames
+  float latency_frames() const;
+
  protected:
+  void free_buffers_();
+  bool allocate_buffers_();
+
+  // Input frames the resampler needs to fill the given output space
+  size_t required_input_frames_(size_t output_frames);
+
+  // Sets the ratio, lowpass, and optional biquads for the configuration's rates, creating the ART resampler or
+  // switching its filters. Leaves the ratio unchanged and returns false if the filters can't be allocated.
+  bool configure_ratio_(ResamplerConfiguration &config);
+
+  // Run every stage over one tile of input_frames in and at most output_frames out
+  ResamplerResults resample_tile_(const uint8_t *input_buffer, uint8_t *output_buffer, size_t input_frames,
+                                  size_t output_frames, float gain_db);
+  ResamplerResults resample_fixed_tile_(const uint8_t *input_buffer, uint8_t *output_buffer, size_t input_frames,
+                                        size_t output_frames, float gain_db);
+
+  // Tile-sized scratch buffers for the floating-point path, allocated only once resampling is needed
   float *float_input_buffer_{nullptr};
   size_t input_buffer_samples_;
+  size_t input_tile_frames_{0};
 
   float *float_output_buffer_{nullptr};
   size_t output_buffer_samples_;
+  size_t output_tile_frames_{0};
+
+  // Frames left in the float scratch buffers by the last tile
+  size_t last_input_frames_{0};
+  size_t last_output_frames_{0};
+
+  // Tile-sized scratch buffers for the fixed-point path; 16-bit samples if neither side has more than 16 bits, 32-bit
+  // otherwise
+  void *fixed_input_buffer_{nullptr};
+  void *fixed_output_buffer_{nullptr};
+  uint8_t fixed_sample_bytes_{0};
 
+  ResamplerConfiguration config_{};
   art_resampler::Resample *resampler_{nullptr};
 
-  art_resampler::Biquad lowpass_[2][2];
-  art_resampler::BiquadCoefficients lowpass_coeff_;
+  IntegerResampler integer_resampler_;
+  bool integer_ratio_{false};  // integer_resampler_ is used instead of resampler_
+
+  InterpolatingResampler interpolating_resampler_;
+  bool interpolate_{false};  // interpolating_resampler_ is used instead of resampler_
+
+  // The optional lowpass is two cascaded biquads (one with interpolation) with the same coefficients, filtering every
+  // channel in one pass with the state in lowpass_state_
+  art_resampler::BiquadCascade lowpass_{};
+  uint8_t lowpass_stages_{2};
+  art_resampler::BiquadCoefficients lowpass_coeffs_[2];
+  float *lowpass_state_{nullptr};
 
   uint16_t number_of_taps_;
   uint16_t number_of_filters_;
@@ -70,6 +159,19 @@ class Resampler {
   float sample_ratio_{1.0};
   float lowpass_ratio_{1.0};
 
+  // ASRC control loop: sample_ratio_ is nominal_ratio_ * (1 + asrc_trim_), set by a PI controller on the smoothed
+  // difference between the sink buffer level and its target
+  float nominal_ratio_{1.0};
+  float asrc_trim_{0.0};
+  float asrc_max_trim_{0.0};
+  float asrc_filtered_error_{0.0};
+  float asrc_integral_{0.0};
+  float asrc_bandwidth_{0.0};  // loop natural frequency, in radians per output frame
+  size_t asrc_target_frames_{0};
+  size_t asrc_frames_generated_{0};
+  bool asrc_{false};
+  bool asrc_primed_{false};
+
   bool pre_filter_{false};
   bool post_filter_{false};
   bool requires_resampling_{false};
@@ -0,0 +1,64 @@
+// Picks the Resampler filter parameters that fit a CPU and memory budget
+
+#pragma once
+
+#include "resampler.h"
+
+namespace esp_audio_libs {
+namespace resampler {
+
+// Linear model of what a Resampler costs per output frame: a fixed part for the sample conversions, filter
+// positioning, and the optional biquads, plus a part for each multiply of the resampling filters. The unit is whatever
+// the costs were measured in, e.g. CPU cycles on the target (see fit()) or nanoseconds on a host (the
+// resampler_benchmark tool fits one to its measurements of each rate pair). A model holds for the rates and engine it
+// was fitted on: the IntegerResampler's multiplies cost more than the ART resampler's, for example.
+struct ResamplerCostModel {
+  float frame_cost;     // cost of each output frame (all channels) apart from the filter multiplies
+  float multiply_cost;  // cost of each filter multiply (see estimate_multiplies_per_frame())
+
+  /// @brief Fits the model to the measured costs of two configurations with different filter lengths, e.g. the cycles
+  /// per output frame of a short calibration run of each on the target
+  /// @param a First configuration
+  /// @param cost_a Measured cost per output frame of the first configuration
+  /// @param b Second configuration, with a different estimate_multiplies_per_frame() than the first
+  /// @param cost_b Measured cost per output frame of the second configuration
+  /// @return The fitted model (all multiply cost if the configurations have the same multiply count)
+  static ResamplerCostModel fit(const ResamplerConfiguration &a, float cost_a, const ResamplerConfiguration &b,
+                                float cost_b);
+};
+
+struct ResamplerBudget {
+  float max_frame_cost;      // processing budget per output frame, in the cost model's unit (0 for no limit)
+  size_t max_memory_bytes;   // heap the Resampler may allocate, including its filters (0 for no limit)
+  ResamplerCostModel model;  // cost of the configurations on the target
+  float min_quality_db;      // good enough quality: the cheapest configuration reaching it wins (0 for the best)
+};
+
+/// @brief Estimates the filter multiplies per output frame (all channels) of a configuration
+float estimate_multiplies_per_frame(const ResamplerConfiguration &config);
+
+/// @brief Estimates the heap a Resampler allocates for a configuration, including the filters (even if they're shared
+/// with another resampler), the tile-sized scratch buffers, and the biquad state
+size_t estimate_memory_bytes(const ResamplerConfiguration &config);
+
+/// @brief Estimates the quality of a configuration in dB: the smaller of the stopband rejection and the THD+N (as a
+/// positive number) anywhere in a passband up to 0.8 of the lower Nyquist frequency. It's taken from
+/// resampler_benchmark measurements (the worst of its rate pairs), with the taps and filters rounded down to the
+/// measured ones: 8 to 64 taps and 16 to 128 filters.
+/// @return Estimated quality, infinite if the rates match (the samples are only converted), or 0 for the
+/// configurations that weren't measured: the interpolation modes, and the ART resampler with fixed point, low latency,
+/// or a rational ratio
+float estimate_quality_db(const ResamplerConfiguration &config);
+
+/// @brief Picks the number of taps, number of filters, and subsample interpolation that fit the budget: the cheapest
+/// reaching budget.min_quality_db, or else the cheapest with the highest estimated quality. The tap counts and filter
+/// counts measured by resampler_benchmark are considered. The rates, channels, and other settings are taken from the
+/// configuration as given, so the choice follows the engine Resampler::initialize() will pick for them.
+/// @param config Configuration to complete; only changed if a configuration fits
+/// @param budget Limits to fit within
+/// @return True if a configuration fits the budget, false otherwise (or for the configurations estimate_quality_db()
+/// doesn't model)
+bool select_configuration(ResamplerConfiguration &config, const ResamplerBudget &budget);
+
+}  // namespace resampler
+}  // namespace esp_audio_libs
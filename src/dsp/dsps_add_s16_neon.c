@@ -0,0 +1,37 @@
+// Addition of two Q15 arrays with NEON. The results are the same as dsps_add_s16_ansi's: without a shift the sums wrap
+// around, and with one, the halved sum (which can't overflow) is shifted by the rest, rounding down like the 32-bit
+// sum would.
+
+#include "dsp.h"
+#include <stddef.h>
+
+#if (dsps_add_s16_neon_enabled == 1)
+
+#include <arm_neon.h>
+
+esp_err_t dsps_add_s16_neon(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1,
+                            int step2, int step_out, int shift) {
+  if (input1 == NULL || input2 == NULL || output == NULL || step1 != 1 || step2 != 1 || step_out != 1 || shift < 0 ||
+      shift >= 32)
+    return dsps_add_s16_ansi(input1, input2, output, len, step1, step2, step_out, shift);
+
+  int i = 0;
+
+  if (shift == 0) {
+    for (; i + 8 <= len; i += 8)
+      vst1q_s16(output + i, vaddq_s16(vld1q_s16(input1 + i), vld1q_s16(input2 + i)));
+  } else {
+    // A negative count shifts right, and counts past 15 leave just the sign, like the 32-bit shift
+    const int16x8_t count = vdupq_n_s16((int16_t) (1 - shift));
+
+    for (; i + 8 <= len; i += 8)
+      vst1q_s16(output + i, vshlq_s16(vhaddq_s16(vld1q_s16(input1 + i), vld1q_s16(input2 + i)), count));
+  }
+
+  for (; i < len; i++)
+    output[i] = ((int32_t) input1[i] + (int32_t) input2[i]) >> shift;
+
+  return ESP_OK;
+}
+
+#endif  // dsps_add_s16_neon_enabled
@@ -0,0 +1,82 @@
+// Addition of two Q15 arrays with SSE2, or with AVX2 on CPUs that have it (see dsps_host_dispatch.c). The results are
+// the same as dsps_add_s16_ansi's: without a shift the sums wrap around, and with one, the halved sum (which can't
+// overflow) is shifted by the rest, rounding down like the 32-bit sum would.
+
+#include "dsp.h"
+#include <stddef.h>
+
+#if (dsps_add_s16_sse_enabled == 1)
+
+#include <immintrin.h>
+
+// Whether the arrays and shift can take the SIMD path; anything else goes to dsps_add_s16_ansi()
+#define ADD_S16_VECTORIZABLE(input1, input2, output, step1, step2, step_out, shift)                                   \
+  ((input1) != NULL && (input2) != NULL && (output) != NULL && (step1) == 1 && (step2) == 1 && (step_out) == 1 &&   \
+   (shift) >= 0 && (shift) < 32)
+
+esp_err_t dsps_add_s16_sse(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1,
+                           int step2, int step_out, int shift) {
+  if (!ADD_S16_VECTORIZABLE(input1, input2, output, step1, step2, step_out, shift))
+    return dsps_add_s16_ansi(input1, input2, output, len, step1, step2, step_out, shift);
+
+  int i = 0;
+
+  if (shift == 0) {
+    for (; i + 8 <= len; i += 8)
+      _mm_storeu_si128((__m128i *) (output + i), _mm_add_epi16(_mm_loadu_si128((const __m128i *) (input1 + i)),
+                                                               _mm_loadu_si128((const __m128i *) (input2 + i))));
+  } else {
+    const __m128i one = _mm_set1_epi16(1), count = _mm_cvtsi32_si128(shift - 1);
+
+    for (; i + 8 <= len; i += 8) {
+      __m128i a = _mm_loadu_si128((const __m128i *) (input1 + i));
+      __m128i b = _mm_loadu_si128((const __m128i *) (input2 + i));
+      __m128i half = _mm_add_epi16(_mm_add_epi16(_mm_srai_epi16(a, 1), _mm_srai_epi16(b, 1)),
+                                   _mm_and_si128(_mm_and_si128(a, b), one));
+      _mm_storeu_si128((__m128i *) (output + i), _mm_sra_epi16(half, count));
+    }
+  }
+
+  for (; i < len; i++)
+    output[i] = ((int32_t) input1[i] + (int32_t) input2[i]) >> shift;
+
+  return ESP_OK;
+}
+
+#endif  // dsps_add_s16_sse_enabled
+
+#if (dsps_add_s16_avx2_enabled == 1)
+
+__attribute__((target("avx2"))) esp_err_t dsps_add_s16_avx2(const int16_t *input1, const int16_t *input2,
+                                                            int16_t *output, int len, int step1, int step2,
+                                                            int step_out, int shift) {
+  if (!ADD_S16_VECTORIZABLE(input1, input2, output, step1, step2, step_out, shift))
+    return dsps_add_s16_ansi(input1, input2, output, len, step1, step2, step_out, shift);
+
+  int i = 0;
+
+  if (shift == 0) {
+    for (; i + 16 <= len; i += 16)
+      _mm256_storeu_si256((__m256i *) (output + i),
+                          _mm256_add_epi16(_mm256_loadu_si256((const __m256i *) (input1 + i)),
+                                           _mm256_loadu_si256((const __m256i *) (input2 + i))));
+  } else {
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m128i count = _mm_cvtsi32_si128(shift - 1);
+
+    for (; i + 16 <= len; i += 16) {
+      __m256i a = _mm256_loadu_si256((const __m256i *) (input1 + i));
+      __m256i b = _mm256_loadu_si256((const __m256i *) (input2 + i));
+      __m256i half = _mm256_add_epi16(_mm256_add_epi16(_mm256_srai_epi16(a, 1), _mm256_srai_epi16(b, 1)),
+                                      _mm256_and_si256(_mm256_and_si256(a, b), one));
+      _mm256_storeu_si256((__m256i *) (output + i), _mm256_sra_epi16(half, count));
+    }
+  }
+
+  for (; i < len; i++)
+    output[i] = ((int32_t) input1[i] + (int32_t) input2[i]) >> shift;
+
+  return ESP_OK;
+}
+
+#endif  // dsps_add_s16_avx2_enabled
@@ -0,0 +1,43 @@
+// Dot product of two float vectors with NEON. Four vector accumulators keep that many multiply-adds in flight, since
+// each one waits on the previous sum in its accumulator. The products are summed in a different order than
+// dsps_dotprod_f32_ansi's, so the last bits differ.
+
+#include "dsp.h"
+
+#if (dsps_dotprod_f32_neon_enabled == 1)
+
+#include <arm_neon.h>
+
+#if defined(__aarch64__)
+#define DOTPROD_MLA(acc, a, b) vfmaq_f32(acc, a, b)
+#define DOTPROD_SUM(acc) vaddvq_f32(acc)
+#else
+#define DOTPROD_MLA(acc, a, b) vmlaq_f32(acc, a, b)
+#define DOTPROD_SUM(acc) \
+  vget_lane_f32(vpadd_f32(vadd_f32(vget_low_f32(acc), vget_high_f32(acc)), vdup_n_f32(0.0f)), 0)
+#endif
+
+esp_err_t dsps_dotprod_f32_neon(const float *src1, const float *src2, float *dest, int len) {
+  float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+  float32x4_t acc2 = vdupq_n_f32(0.0f), acc3 = vdupq_n_f32(0.0f);
+  int i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    acc0 = DOTPROD_MLA(acc0, vld1q_f32(src1 + i), vld1q_f32(src2 + i));
+    acc1 = DOTPROD_MLA(acc1, vld1q_f32(src1 + i + 4), vld1q_f32(src2 + i + 4));
+    acc2 = DOTPROD_MLA(acc2, vld1q_f32(src1 + i + 8), vld1q_f32(src2 + i + 8));
+    acc3 = DOTPROD_MLA(acc3, vld1q_f32(src1 + i + 12), vld1q_f32(src2 + i + 12));
+  }
+
+  for (; i + 4 <= len; i += 4)
+    acc0 = DOTPROD_MLA(acc0, vld1q_f32(src1 + i), vld1q_f32(src2 + i));
+
+  float sum = DOTPROD_SUM(vaddq_f32(vaddq_f32(acc0, acc1), vaddq_f32(acc2, acc3)));
+  for (; i < len; i++)
+    sum += src1[i] * src2[i];
+
+  *dest = sum;
+  return ESP_OK;
+}
+
+#endif  // dsps_dotprod_f32_neon_enabled
@@ -0,0 +1,86 @@
+// Dot product of two float vectors with SSE, or with AVX2 and FMA on CPUs that have them (see dsps_host_dispatch.c).
+// Four vector accumulators keep that many multiply-adds in flight, since each one waits on the previous sum in its
+// accumulator. The products are summed in a different order than dsps_dotprod_f32_ansi's, so the last bits differ.
+
+#include "dsp.h"
+
+#if (dsps_dotprod_f32_sse_enabled == 1)
+
+#include <immintrin.h>
+
+esp_err_t dsps_dotprod_f32_sse(const float *src1, const float *src2, float *dest, int len) {
+  __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+  int i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(src1 + i), _mm_loadu_ps(src2 + i)));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(src1 + i + 4), _mm_loadu_ps(src2 + i + 4)));
+    acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(src1 + i + 8), _mm_loadu_ps(src2 + i + 8)));
+    acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(src1 + i + 12), _mm_loadu_ps(src2 + i + 12)));
+  }
+
+  for (; i + 4 <= len; i += 4)
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(src1 + i), _mm_loadu_ps(src2 + i)));
+
+  __m128 acc = _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3));
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+
+  float sum = _mm_cvtss_f32(acc);
+  for (; i < len; i++)
+    sum += src1[i] * src2[i];
+
+  *dest = sum;
+  return ESP_OK;
+}
+
+#endif  // dsps_dotprod_f32_sse_enabled
+
+#if (dsps_dotprod_f32_avx2_enabled == 1)
+
+__attribute__((target("avx2,fma"))) esp_err_t dsps_dotprod_f32_avx2(const float *src1, const float *src2, float *dest,
+                                                                    int len) {
+  __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+  __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+  int i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(src1 + i), _mm256_loadu_ps(src2 + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(src1 + i + 8), _mm256_loadu_ps(src2 + i + 8), acc1);
+    acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(src1 + i + 16), _mm256_loadu_ps(src2 + i + 16), acc2);
+    acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(src1 + i + 24), _mm256_loadu_ps(src2 + i + 24), acc3);
+  }
+
+  // What's left is under 32 floats, taken in independent steps so short filters don't wait on one accumulator
+  if (i + 16 <= len) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(src1 + i), _mm256_loadu_ps(src2 + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(src1 + i + 8), _mm256_loadu_ps(src2 + i + 8), acc1);
+    i += 16;
+  }
+
+  if (i + 8 <= len) {
+    acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(src1 + i), _mm256_loadu_ps(src2 + i), acc2);
+    i += 8;
+  }
+
+  __m256 acc8 = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+  __m128 acc = _mm_add_ps(_mm256_castps256_ps128(acc8), _mm256_extractf128_ps(acc8, 1));
+
+  // The resampler's filters are multiples of 4 taps, so a last group of 4 is common
+  if (i + 4 <= len) {
+    acc = _mm_fmadd_ps(_mm_loadu_ps(src1 + i), _mm_loadu_ps(src2 + i), acc);
+    i += 4;
+  }
+
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+
+  float sum = _mm_cvtss_f32(acc);
+  for (; i < len; i++)
+    sum += src1[i] * src2[i];
+
+  *dest = sum;
+  return ESP_OK;
+}
+
+#endif  // dsps_dotprod_f32_avx2_enabled
@@ -0,0 +1,60 @@
+// The _host functions that dsp.h maps dsps_dotprod_f32, dsps_add_s16, and dsps_mulc_s16 to on hosts. They call the
+// SIMD kernels for the CPU they run on: AVX2 (with FMA) if it has them and SSE2 otherwise on x86, and NEON on ARM. The
+// CPU is checked once, on the first call.
+
+#include "dsp.h"
+#include <stddef.h>
+
+#if (dsps_host_enabled == 1)
+
+typedef struct {
+  const char *name;
+  esp_err_t (*dotprod_f32)(const float *src1, const float *src2, float *dest, int len);
+  esp_err_t (*add_s16)(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1, int step2,
+                       int step_out, int shift);
+  esp_err_t (*mulc_s16)(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out);
+} HostBackend;
+
+#if (dsps_dotprod_f32_sse_enabled == 1)
+static const HostBackend avx2_backend = {"avx2", dsps_dotprod_f32_avx2, dsps_add_s16_avx2, dsps_mulc_s16_avx2};
+static const HostBackend sse_backend = {"sse", dsps_dotprod_f32_sse, dsps_add_s16_sse, dsps_mulc_s16_sse};
+#else
+static const HostBackend neon_backend = {"neon", dsps_dotprod_f32_neon, dsps_add_s16_neon, dsps_mulc_s16_neon};
+#endif
+
+static const HostBackend *selected_backend = NULL;
+
+static const HostBackend *host_backend(void) {
+  const HostBackend *backend = __atomic_load_n(&selected_backend, __ATOMIC_ACQUIRE);
+
+  if (backend == NULL) {
+#if (dsps_dotprod_f32_sse_enabled == 1)
+    // __builtin_cpu_supports() also checks that the OS saves the AVX registers
+    __builtin_cpu_init();
+    backend = (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? &avx2_backend : &sse_backend;
+#else
+    backend = &neon_backend;
+#endif
+    // Threads racing here all pick the same backend, so whichever store lands is fine
+    __atomic_store_n(&selected_backend, backend, __ATOMIC_RELEASE);
+  }
+
+  return backend;
+}
+
+const char *dsps_host_backend(void) { return host_backend()->name; }
+
+esp_err_t dsps_dotprod_f32_host(const float *src1, const float *src2, float *dest, int len) {
+  return host_backend()->dotprod_f32(src1, src2, dest, len);
+}
+
+esp_err_t dsps_add_s16_host(const int16_t *input1, const int16_t *input2, int16_t *output, int len, int step1,
+                            int step2, int step_out, int shift) {
+  return host_backend()->add_s16(input1, input2, output, len, step1, step2, step_out, shift);
+}
+
+esp_err_t dsps_mulc_s16_host(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out) {
+  return host_backend()->mulc_s16(input, output, len, C, step_in, step_out);
+}
+
+#endif  // dsps_host_enabled
@@ -0,0 +1,31 @@
+// Multiplication of a Q15 array by a constant with NEON. Each 32-bit product is narrowed to its bits 15 to 30, which
+// is exactly what dsps_mulc_s16_ansi keeps, including its wraparound for -1 times -1.
+
+#include "dsp.h"
+#include <stddef.h>
+
+#if (dsps_mulc_s16_neon_enabled == 1)
+
+#include <arm_neon.h>
+
+esp_err_t dsps_mulc_s16_neon(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out) {
+  if (input == NULL || output == NULL || step_in != 1 || step_out != 1)
+    return dsps_mulc_s16_ansi(input, output, len, C, step_in, step_out);
+
+  const int16x4_t constant = vdup_n_s16(C);
+  int i = 0;
+
+  for (; i + 8 <= len; i += 8) {
+    int16x8_t x = vld1q_s16(input + i);
+    int16x4_t low = vshrn_n_s32(vmull_s16(vget_low_s16(x), constant), 15);
+    int16x4_t high = vshrn_n_s32(vmull_s16(vget_high_s16(x), constant), 15);
+    vst1q_s16(output + i, vcombine_s16(low, high));
+  }
+
+  for (; i < len; i++)
+    output[i] = (int16_t) (((int32_t) input[i] * (int32_t) C) >> 15);
+
+  return ESP_OK;
+}
+
+#endif  // dsps_mulc_s16_neon_enabled
@@ -0,0 +1,56 @@
+// Multiplication of a Q15 array by a constant with SSE2, or with AVX2 on CPUs that have it (see
+// dsps_host_dispatch.c). The low and high halves of each 32-bit product are combined into its bits 15 to 30, which is
+// exactly what dsps_mulc_s16_ansi keeps, including its wraparound for -1 times -1.
+
+#include "dsp.h"
+#include <stddef.h>
+
+#if (dsps_mulc_s16_sse_enabled == 1)
+
+#include <immintrin.h>
+
+esp_err_t dsps_mulc_s16_sse(const int16_t *input, int16_t *output, int len, int16_t C, int step_in, int step_out) {
+  if (input == NULL || output == NULL || step_in != 1 || step_out != 1)
+    return dsps_mulc_s16_ansi(input, output, len, C, step_in, step_out);
+
+  const __m128i constant = _mm_set1_epi16(C);
+  int i = 0;
+
+  for (; i + 8 <= len; i += 8) {
+    __m128i x = _mm_loadu_si128((const __m128i *) (input + i));
+    __m128i low = _mm_mullo_epi16(x, constant), high = _mm_mulhi_epi16(x, constant);
+    _mm_storeu_si128((__m128i *) (output + i), _mm_or_si128(_mm_slli_epi16(high, 1), _mm_srli_epi16(low, 15)));
+  }
+
+  for (; i < len; i++)
+    output[i] = (int16_t) (((int32_t) input[i] * (int32_t) C) >> 15);
+
+  return ESP_OK;
+}
+
+#endif  // dsps_mulc_s16_sse_enabled
+
+#if (dsps_mulc_s16_avx2_enabled == 1)
+
+__attribute__((target("avx2"))) esp_err_t dsps_mulc_s16_avx2(const int16_t *input, int16_t *output, int len,
+                                                             int16_t C, int step_in, int step_out) {
+  if (input == NULL || output == NULL || step_in != 1 || step_out != 1)
+    return dsps_mulc_s16_ansi(input, output, len, C, step_in, step_out);
+
+  const __m256i constant = _mm256_set1_epi16(C);
+  int i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    __m256i x = _mm256_loadu_si256((const __m256i *) (input + i));
+    __m256i low = _mm256_mullo_epi16(x, constant), high = _mm256_mulhi_epi16(x, constant);
+    _mm256_storeu_si256((__m256i *) (output + i),
+                        _mm256_or_si256(_mm256_slli_epi16(high, 1), _mm256_srli_epi16(low, 15)));
+  }
+
+  for (; i < len; i++)
+    output[i] = (int16_t) (((int32_t) input[i] * (int32_t) C) >> 15);
+
+  return ESP_OK;
+}
+
+#endif  // dsps_mulc_s16_avx2_enabled
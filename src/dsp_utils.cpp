@@ -0,0 +1,16 @@
+#include "dsp_utils.h"
+#include "dsp.h"
+
+namespace esp_audio_libs {
+namespace internal {
+
+void multiply_constant_s16(const int16_t* input, int16_t* output, size_t len, int16_t constant, int step_out) {
+    dsps_mulc_s16(input, output, (int) (len & ~(size_t) 1), constant, 1, step_out);
+
+    if (len & 1) {
+        output[(len - 1) * step_out] = (int16_t) (((int32_t) input[len - 1] * constant) >> 15);
+    }
+}
+
+}  // namespace internal
+}  // namespace esp_audio_libs
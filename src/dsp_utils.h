@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_audio_libs {
+namespace internal {
+
+/**
+ * @brief Multiply packed Q15 samples by a constant with dsps_mulc_s16
+ *
+ * The ESP32's dsps_mulc_s16 kernel multiplies two samples per loop, reading them as a pair, so it skips an odd last
+ * sample and mishandles any input step but 1. This only takes packed input, and multiplies an odd last sample itself.
+ *
+ * @param input Pointer to the input samples
+ * @param output Pointer to the output samples (can be the input)
+ * @param len Number of samples
+ * @param constant Q15 constant
+ * @param step_out Step over the output samples
+ */
+void multiply_constant_s16(const int16_t* input, int16_t* output, size_t len, int16_t constant, int step_out);
+
+}  // namespace internal
+}  // namespace esp_audio_libs
@@ -0,0 +1,190 @@
+#include "parametric_equalizer.h"
+#include "../memory_utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esp_audio_libs {
+namespace equalizer {
+
+// Frames crossfaded at a time, which sets the size of the buffer for the new filters' output
+static const size_t FADE_BLOCK_FRAMES = 64;
+
+// Designs the biquad for a band at the given sample rate. A band that's off is a section that passes its input through.
+static void design_band(const EqualizerBand &band, float sample_rate, art_resampler::BiquadCoefficients *coeffs) {
+  const float frequency = band.frequency / sample_rate;
+
+  switch (band.type) {
+    case EQUALIZER_BAND_PEAKING:
+      art_resampler::biquad_peaking(coeffs, frequency, band.q, band.gain_db);
+      break;
+    case EQUALIZER_BAND_LOW_SHELF:
+      art_resampler::biquad_low_shelf(coeffs, frequency, band.q, band.gain_db);
+      break;
+    case EQUALIZER_BAND_HIGH_SHELF:
+      art_resampler::biquad_high_shelf(coeffs, frequency, band.q, band.gain_db);
+      break;
+    case EQUALIZER_BAND_NOTCH:
+      art_resampler::biquad_notch(coeffs, frequency, band.q);
+      break;
+    default:
+      *coeffs = {.a0 = 1.0f, .a1 = 0.0f, .a2 = 0.0f, .b1 = 0.0f, .b2 = 0.0f};
+      break;
+  }
+}
+
+bool ParametricEqualizer::initialize(uint8_t channels, float sample_rate, uint8_t bands, float fade_ms) {
+  this->release();
+
+  if ((channels == 0) || (bands == 0) || !(sample_rate > 0.0f) || !(fade_ms >= 0.0f)) {
+    return false;
+  }
+
+  // The band settings, both sets of coefficients and state, and the crossfade buffer share one allocation
+  const size_t state_samples = BIQUAD_CASCADE_STATE_SIZE(bands, channels);
+  const size_t size = bands * sizeof(EqualizerBand) + 2 * bands * sizeof(art_resampler::BiquadCoefficients) +
+                      (2 * state_samples + FADE_BLOCK_FRAMES * channels) * sizeof(float);
+  uint8_t *memory = (uint8_t *) internal::alloc_psram_fallback(size);
+
+  if (memory == nullptr) {
+    return false;
+  }
+
+  this->bands_ = (EqualizerBand *) memory;
+  memory += bands * sizeof(EqualizerBand);
+
+  for (int i = 0; i < 2; ++i) {
+    this->coeffs_[i] = (art_resampler::BiquadCoefficients *) memory;
+    memory += bands * sizeof(art_resampler::BiquadCoefficients);
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    this->state_[i] = (float *) memory;
+    memory += state_samples * sizeof(float);
+  }
+
+  this->fade_buffer_ = (float *) memory;
+
+  this->band_count_ = bands;
+  this->channels_ = channels;
+  this->sample_rate_ = sample_rate;
+  this->fade_frames_ = (size_t) (sample_rate * fade_ms / 1000.0f + 0.5f);
+
+  for (uint8_t i = 0; i < bands; ++i) {
+    this->bands_[i] = {.type = EQUALIZER_BAND_OFF, .frequency = 1000.0f, .q = 0.707f, .gain_db = 0.0f};
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    art_resampler::biquad_cascade_init(&this->cascades_[i], this->coeffs_[i], bands, this->state_[i], channels);
+  }
+
+  this->reset();
+
+  return true;
+}
+
+void ParametricEqualizer::release() {
+  // bands_ is the start of the one allocation
+  internal::free_psram_fallback(this->bands_);
+
+  this->bands_ = nullptr;
+  this->coeffs_[0] = this->coeffs_[1] = nullptr;
+  this->state_[0] = this->state_[1] = nullptr;
+  this->fade_buffer_ = nullptr;
+  this->band_count_ = 0;
+}
+
+bool ParametricEqualizer::set_band(uint8_t index, const EqualizerBand &band) {
+  if ((index >= this->band_count_) || !(band.frequency > 0.0f) || !(band.frequency < this->sample_rate_ / 2.0f) ||
+      !(band.q > 0.0f)) {
+    return false;
+  }
+
+  this->bands_[index] = band;
+
+  if (this->is_fading()) {
+    this->changed_ = true;
+  } else {
+    this->start_fade_();
+  }
+
+  return true;
+}
+
+void ParametricEqualizer::reset() {
+  this->design_(this->coeffs_[this->current_]);
+  memset(this->state_[this->current_], 0,
+         BIQUAD_CASCADE_STATE_SIZE(this->band_count_, this->channels_) * sizeof(float));
+
+  this->fade_position_ = this->fade_frames_;
+  this->changed_ = false;
+}
+
+void ParametricEqualizer::process(float *buffer, size_t frames) {
+  while (frames > 0) {
+    if (!this->is_fading()) {
+      art_resampler::biquad_cascade_apply_interleaved(&this->cascades_[this->current_], buffer, frames);
+      return;
+    }
+
+    // Both sets of filters run on the block, and the output moves linearly from the current ones' to the new ones'
+    const size_t block = std::min(std::min(frames, FADE_BLOCK_FRAMES), this->fade_frames_ - this->fade_position_);
+    const size_t samples = block * this->channels_;
+    const uint8_t next = this->current_ ^ 1;
+
+    memcpy(this->fade_buffer_, buffer, samples * sizeof(float));
+    art_resampler::biquad_cascade_apply_interleaved(&this->cascades_[this->current_], buffer, block);
+    art_resampler::biquad_cascade_apply_interleaved(&this->cascades_[next], this->fade_buffer_, block);
+
+    const float step = 1.0f / this->fade_frames_;
+    float weight = this->fade_position_ * step;
+
+    for (size_t i = 0; i < samples; i += this->channels_) {
+      weight += step;
+
+      for (size_t j = i; j < i + this->channels_; ++j) {
+        buffer[j] += weight * (this->fade_buffer_[j] - buffer[j]);
+      }
+    }
+
+    this->fade_position_ += block;
+
+    if (!this->is_fading()) {
+      this->current_ = next;
+
+      if (this->changed_) {
+        this->start_fade_();
+      }
+    }
+
+    buffer += samples;
+    frames -= block;
+  }
+}
+
+void ParametricEqualizer::design_(art_resampler::BiquadCoefficients *coeffs) const {
+  for (uint8_t i = 0; i < this->band_count_; ++i) {
+    design_band(this->bands_[i], this->sample_rate_, &coeffs[i]);
+  }
+}
+
+// The new filters start from the current ones' state. That's exact for the bands that didn't change, and close for
+// small changes, like a sweep of a control. A band that changes a lot takes a moment to ring in, which the crossfade
+// hides.
+void ParametricEqualizer::start_fade_() {
+  const uint8_t next = this->current_ ^ 1;
+
+  this->design_(this->coeffs_[next]);
+  memcpy(this->state_[next], this->state_[this->current_],
+         BIQUAD_CASCADE_STATE_SIZE(this->band_count_, this->channels_) * sizeof(float));
+  this->changed_ = false;
+
+  if (this->fade_frames_ == 0) {
+    this->current_ = next;
+  } else {
+    this->fade_position_ = 0;
+  }
+}
+
+}  // namespace equalizer
+}  // namespace esp_audio_libs
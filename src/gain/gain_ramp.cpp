@@ -0,0 +1,130 @@
+#include "gain_ramp.h"
+#include "../dsp_utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace esp_audio_libs {
+namespace gain {
+
+// Gains below this are silence, and the limit fits the Q24 gains of the conversions in quantization_utils
+static const float GAIN_SILENT = 1e-6f;  // -120 dB
+static const float GAIN_MAX = 125.0f;    // about +42 dB
+
+// Where exponential ramps to or from silence start or stop moving by a constant number of dB per frame
+static const float GAIN_RAMP_FLOOR = 1e-4f;  // -80 dB
+
+static float db_to_gain(float gain_db) {
+  const float gain = powf(10.0f, gain_db / 20.0f);
+  return (gain < GAIN_SILENT) ? 0.0f : std::min(gain, GAIN_MAX);
+}
+
+void GainRamp::initialize(uint8_t channels, float sample_rate, float gain_db) {
+  this->channels_ = std::max(channels, (uint8_t) 1);
+  this->sample_rate_ = sample_rate;
+  this->volume_ = db_to_gain(gain_db);
+  this->muted_ = false;
+
+  this->gain_ = this->target_gain_ = this->volume_;
+  this->remaining_ = 0;
+}
+
+void GainRamp::set_gain(float gain_db, float ramp_ms, GainRampShape shape) {
+  this->volume_ = db_to_gain(gain_db);
+
+  if (!this->muted_) {
+    this->start_ramp_(this->volume_, ramp_ms, shape);
+  }
+}
+
+void GainRamp::set_muted(bool muted, float ramp_ms, GainRampShape shape) {
+  this->muted_ = muted;
+  this->start_ramp_(muted ? 0.0f : this->volume_, ramp_ms, shape);
+}
+
+void GainRamp::fade_in(float ramp_ms, GainRampShape shape) {
+  this->gain_ = 0.0f;
+  this->remaining_ = 0;
+  this->set_muted(false, ramp_ms, shape);
+}
+
+void GainRamp::fade_out(float ramp_ms, GainRampShape shape) { this->set_muted(true, ramp_ms, shape); }
+
+void GainRamp::process(float *buffer, size_t frames) {
+  if (!this->is_ramping() && (this->gain_ == 1.0f)) {
+    return;
+  }
+
+  const uint8_t channels = this->channels_;
+
+  this->for_each_frame(frames, [buffer, channels](size_t index, float gain) {
+    float *frame = buffer + index * channels;
+    for (uint8_t channel = 0; channel < channels; ++channel) {
+      frame[channel] *= gain;
+    }
+  });
+}
+
+uint32_t GainRamp::process(int16_t *buffer, size_t frames) {
+  if (!this->is_ramping()) {
+    if (this->gain_ == 1.0f) {
+      return 0;
+    }
+
+    // A steady cut is a constant multiply, which the esp-dsp kernel does (with SIMD on the ESP32-S3 and hosts)
+    const int32_t constant = (int32_t) (this->gain_ * 32768.0f + 0.5f);
+    if (constant < 32768) {
+      internal::multiply_constant_s16(buffer, buffer, frames * this->channels_, (int16_t) constant, 1);
+      return 0;
+    }
+  }
+
+  const uint8_t channels = this->channels_;
+  uint32_t clipped_samples = 0;
+
+  this->for_each_frame(frames, [buffer, channels, &clipped_samples](size_t index, float gain) {
+    const int32_t constant = (int32_t) (gain * 32768.0f + 0.5f);
+    int16_t *frame = buffer + index * channels;
+
+    for (uint8_t channel = 0; channel < channels; ++channel) {
+      int64_t value = ((int64_t) frame[channel] * constant) >> 15;
+
+      if (value > INT16_MAX) {
+        ++clipped_samples;
+        value = INT16_MAX;
+      } else if (value < INT16_MIN) {
+        ++clipped_samples;
+        value = INT16_MIN;
+      }
+      frame[channel] = (int16_t) value;
+    }
+  });
+
+  return clipped_samples;
+}
+
+void GainRamp::start_ramp_(float target, float ramp_ms, GainRampShape shape) {
+  const size_t frames = (size_t) std::max(this->sample_rate_ * ramp_ms / 1000.0f + 0.5f, 0.0f);
+
+  this->target_gain_ = target;
+  this->shape_ = shape;
+
+  if ((frames == 0) || (target == this->gain_)) {
+    this->gain_ = target;
+    this->remaining_ = 0;
+    return;
+  }
+
+  if (shape == GAIN_RAMP_LINEAR) {
+    this->step_ = (target - this->gain_) / frames;
+  } else {
+    // Silence is approached from (or left at) the floor, and the ramp lands on the exact target at the end
+    this->gain_ = std::max(this->gain_, GAIN_RAMP_FLOOR);
+    this->step_ = powf(std::max(target, GAIN_RAMP_FLOOR) / this->gain_, 1.0f / frames);
+  }
+
+  this->remaining_ = frames;
+}
+
+}  // namespace gain
+}  // namespace esp_audio_libs
@@ -0,0 +1,281 @@
+#include "audio_mixer.h"
+#include "dsp.h"
+#include "../dsp_utils.h"
+#include "../memory_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace esp_audio_libs {
+namespace mixer {
+
+// Frames mixed with the same gains, which is how often the ramps and the ducking envelope move
+static const size_t MIXER_STEP_FRAMES = 32;
+
+// Samples of the 32-bit sum handled together, a count the compiler can vectorize. A block of frames is padded up to a
+// multiple of it, which the blocks allocated for MIXER_STEP_FRAMES frames always hold.
+static const size_t MIXER_GROUP_SAMPLES = 8;
+
+// Gains below this are treated as silence, and the gain limit keeps the 32-bit sum of the streams in range
+static const float MIXER_MUTE_GAIN = 3.2e-5f;  // -90 dB
+static const float MIXER_MAX_GAIN = 15.85f;    // +24 dB
+
+// Q15 constant for a gain of exactly 1, which the kernels can't multiply by, so it's a copy instead
+static const int32_t MIXER_UNITY = 32768;
+
+static float db_to_gain(float gain_db) {
+  const float gain = powf(10.0f, gain_db / 20.0f);
+  return (gain < MIXER_MUTE_GAIN) ? 0.0f : std::min(gain, MIXER_MAX_GAIN);
+}
+
+bool AudioMixer::initialize(uint8_t streams, uint8_t channels, float sample_rate) {
+  this->release();
+
+  if ((streams == 0) || (channels == 0) || !(sample_rate > 0.0f)) {
+    return false;
+  }
+
+  // The stream states and the blocks of frames share one allocation
+  const size_t block_samples = MIXER_STEP_FRAMES * channels;
+  uint8_t *memory = (uint8_t *) internal::alloc_psram_fallback(
+      2 * block_samples * sizeof(int16_t) + block_samples * sizeof(int32_t) + streams * sizeof(StreamState));
+
+  if (memory == nullptr) {
+    return false;
+  }
+
+  // The padding of a short block is read before anything is written there
+  memset(memory, 0, 2 * block_samples * sizeof(int16_t) + block_samples * sizeof(int32_t));
+
+  this->scratch_ = (int16_t *) memory;
+  this->scaled_ = this->scratch_ + block_samples;
+  this->sums_ = (int32_t *) (this->scaled_ + block_samples);
+  this->streams_ = (StreamState *) (this->sums_ + block_samples);
+
+  this->stream_count_ = streams;
+  this->channels_ = channels;
+  this->sample_rate_ = sample_rate;
+
+  for (uint8_t i = 0; i < streams; ++i) {
+    this->streams_[i] = {.gain = 1.0f, .target_gain = 1.0f, .gain_step = 0.0f, .announcement = false};
+  }
+
+  this->duck_gain_ = 1.0f;
+  this->set_ducking(-12.0f);
+
+  return true;
+}
+
+void AudioMixer::release() {
+  // scratch_ is the start of the one allocation
+  internal::free_psram_fallback(this->scratch_);
+
+  this->scratch_ = nullptr;
+  this->scaled_ = nullptr;
+  this->sums_ = nullptr;
+  this->streams_ = nullptr;
+  this->stream_count_ = 0;
+}
+
+void AudioMixer::set_gain(uint8_t stream, float gain_db, float ramp_ms) {
+  if (stream >= this->stream_count_) {
+    return;
+  }
+
+  StreamState &state = this->streams_[stream];
+  const float ramp_frames = this->sample_rate_ * ramp_ms / 1000.0f;
+
+  state.target_gain = db_to_gain(gain_db);
+
+  if (ramp_frames >= 1.0f) {
+    state.gain_step = (state.target_gain - state.gain) / ramp_frames;
+  } else {
+    state.gain = state.target_gain;
+  }
+}
+
+void AudioMixer::set_ducking(float depth_db, float attack_ms, float release_ms) {
+  // The envelope moves by a constant number of dB per frame, so it can't start from or reach silence
+  this->duck_depth_ = powf(10.0f, std::max(std::min(depth_db, 0.0f), -90.0f) / 20.0f);
+
+  const float attack_frames = this->sample_rate_ * attack_ms / 1000.0f;
+  const float release_frames = this->sample_rate_ * release_ms / 1000.0f;
+
+  this->duck_attack_factor_ = (attack_frames >= 1.0f) ? powf(this->duck_depth_, 1.0f / attack_frames) : 0.0f;
+  this->duck_release_factor_ =
+      (release_frames >= 1.0f) ? powf(this->duck_depth_, -1.0f / release_frames) : 1.0f / this->duck_depth_;
+}
+
+void AudioMixer::set_announcement(uint8_t stream, bool announcement) {
+  if (stream < this->stream_count_) {
+    this->streams_[stream].announcement = announcement;
+  }
+}
+
+uint32_t AudioMixer::mix(const MixerInput *inputs, int16_t *output, size_t frames, uint8_t output_stride) {
+  const uint8_t channels = this->channels_;
+  const int out_stride = output_stride ? output_stride : channels;
+  uint32_t clipped = 0;
+
+  bool announcing = false;
+  for (uint8_t i = 0; i < this->stream_count_; ++i) {
+    announcing |= this->streams_[i].announcement && (inputs[i].samples != nullptr);
+  }
+
+  for (size_t done = 0; done < frames;) {
+    const size_t block = std::min(frames - done, MIXER_STEP_FRAMES);
+    const size_t samples = block * channels;
+
+    // Gains adding up to 1 or less keep the sum of the scaled samples within 16 bits (a stream's scaled samples are at
+    // most its Q15 constant in magnitude), so the streams are added with the Q15 kernel, which wraps around on
+    // overflow, right in the output when its frames are packed. Louder mixes are added up in 32 bits instead and
+    // saturated once, as they're written out, so the streams keep their full precision.
+    float total_gain = 0.0f;
+    for (uint8_t i = 0; i < this->stream_count_; ++i) {
+      if (inputs[i].samples != nullptr) {
+        const StreamState &state = this->streams_[i];
+        total_gain += state.announcement ? state.gain : state.gain * this->duck_gain_;
+      }
+    }
+
+    const bool wide = (total_gain > 1.0f);
+    const size_t padded = (samples + MIXER_GROUP_SAMPLES - 1) / MIXER_GROUP_SAMPLES * MIXER_GROUP_SAMPLES;
+    int16_t *mixed = (!wide && (out_stride == channels)) ? output + done * out_stride : this->scratch_;
+    int32_t *sums = this->sums_;
+    bool empty = true;
+
+    for (uint8_t i = 0; i < this->stream_count_; ++i) {
+      const StreamState &state = this->streams_[i];
+      const float gain = state.announcement ? state.gain : state.gain * this->duck_gain_;
+
+      // A gain above 1 doesn't fit in a Q15 constant, so the stream is scaled down by a power of two and shifted back
+      // up in the 32-bit sum (only ever when the sum is wide). Rounded down, so the constants of a narrow sum can't
+      // add up to more than 1.
+      int shift = 0;
+      while ((gain * (float) (MIXER_UNITY >> shift) > (float) MIXER_UNITY) && (shift < 15)) {
+        ++shift;
+      }
+      const int32_t constant = std::min((int32_t) (gain * (float) (MIXER_UNITY >> shift)), MIXER_UNITY);
+
+      if ((inputs[i].samples == nullptr) || (constant == 0)) {
+        continue;
+      }
+
+      MixerInput input = inputs[i];
+      input.samples += done * (input.stride ? input.stride : input.channels);
+
+      if (wide) {
+        const int16_t *scaled = this->scaled_;
+        const int32_t factor = 1 << shift;
+        this->scale_(input, block, constant, this->scaled_);
+
+        if (empty) {
+          for (size_t group = 0; group < padded; group += MIXER_GROUP_SAMPLES) {
+            for (size_t k = 0; k < MIXER_GROUP_SAMPLES; ++k) {
+              sums[group + k] = scaled[group + k] * factor;
+            }
+          }
+        } else {
+          for (size_t group = 0; group < padded; group += MIXER_GROUP_SAMPLES) {
+            for (size_t k = 0; k < MIXER_GROUP_SAMPLES; ++k) {
+              sums[group + k] += scaled[group + k] * factor;
+            }
+          }
+        }
+      } else if (empty) {
+        this->scale_(input, block, constant, mixed);
+      } else {
+        this->scale_(input, block, constant, this->scaled_);
+        dsps_add_s16(mixed, this->scaled_, mixed, (int) samples, 1, 1, 1, 0);
+      }
+      empty = false;
+    }
+
+    if (wide) {
+      // Saturate the sum into the block of mixed frames, with the padding cleared so it can't count as clipped
+      memset(sums + (empty ? 0 : samples), 0, (padded - (empty ? 0 : samples)) * sizeof(int32_t));
+
+      for (size_t group = 0; group < padded; group += MIXER_GROUP_SAMPLES) {
+        for (size_t k = 0; k < MIXER_GROUP_SAMPLES; ++k) {
+          const int32_t value = sums[group + k];
+          clipped += (value > INT16_MAX) + (value < INT16_MIN);
+          mixed[group + k] = (int16_t) std::min<int32_t>(std::max<int32_t>(value, INT16_MIN), INT16_MAX);
+        }
+      }
+    } else if (empty) {
+      memset(mixed, 0, samples * sizeof(int16_t));
+    }
+
+    int16_t *destination = output + done * out_stride;
+
+    if (mixed != destination) {
+      for (size_t frame = 0; frame < block; ++frame, destination += out_stride) {
+        memcpy(destination, mixed + frame * channels, channels * sizeof(int16_t));
+      }
+    }
+
+    this->advance_(block, announcing);
+    done += block;
+  }
+
+  return clipped;
+}
+
+void AudioMixer::advance_(size_t frames, bool announcing) {
+  for (uint8_t i = 0; i < this->stream_count_; ++i) {
+    StreamState &state = this->streams_[i];
+
+    if (state.gain != state.target_gain) {
+      const float gain = state.gain + state.gain_step * frames;
+      const bool reached = (state.gain_step > 0.0f) ? (gain >= state.target_gain) : (gain <= state.target_gain);
+      state.gain = reached ? state.target_gain : gain;
+    }
+  }
+
+  if (announcing && (this->duck_gain_ > this->duck_depth_)) {
+    this->duck_gain_ = std::max(this->duck_gain_ * powf(this->duck_attack_factor_, frames), this->duck_depth_);
+  } else if (!announcing && (this->duck_gain_ < 1.0f)) {
+    this->duck_gain_ = std::min(this->duck_gain_ * powf(this->duck_release_factor_, frames), 1.0f);
+  }
+}
+
+void AudioMixer::scale_(const MixerInput &input, size_t frames, int32_t constant, int16_t *destination) {
+  const uint8_t channels = this->channels_;
+  const size_t stride = input.stride ? input.stride : input.channels;
+  const size_t samples = frames * channels;
+  const int16_t *source = input.samples;
+
+  if ((input.channels == 1) && (stride == 1) && (channels > 1)) {
+    // A packed mono stream is multiplied straight into each channel of the frames
+    for (uint8_t channel = 0; channel < channels; ++channel) {
+      if (constant == MIXER_UNITY) {
+        for (size_t frame = 0; frame < frames; ++frame) {
+          destination[frame * channels + channel] = source[frame];
+        }
+      } else {
+        internal::multiply_constant_s16(source, destination + channel, frames, (int16_t) constant, channels);
+      }
+    }
+    return;
+  }
+
+  if (stride != channels) {
+    // Frames with other samples between them (or a mono stream with a stride) are gathered first
+    for (size_t frame = 0; frame < frames; ++frame) {
+      for (uint8_t channel = 0; channel < channels; ++channel) {
+        destination[frame * channels + channel] = source[frame * stride + ((input.channels == 1) ? 0 : channel)];
+      }
+    }
+    source = destination;
+  }
+
+  if (constant != MIXER_UNITY) {
+    internal::multiply_constant_s16(source, destination, samples, (int16_t) constant, 1);
+  } else if (source != destination) {
+    memcpy(destination, source, samples * sizeof(int16_t));
+  }
+}
+
+}  // namespace mixer
+}  // namespace esp_audio_libs
@@ -1,8 +1,81 @@
 #include "quantization_utils.h"
+#include "gain_ramp.h"
+
+#include <string.h>
 
 namespace esp_audio_libs {
 namespace quantization_utils {
 
+// Fixed point gains are Q24, allowing up to about +42 dB
+static const int FIXED_GAIN_BITS = 24;
+
+// Reads one quantized sample as a left-justified 32-bit value
+static inline int32_t read_quantized(const uint8_t *input, uint8_t input_bits) {
+  if (input_bits <= 8) {
+    return (int32_t) ((uint32_t) (input[0] ^ 0x80) << 24);
+  } else if (input_bits <= 16) {
+    return (int32_t) ((uint32_t) input[0] << 16 | (uint32_t) input[1] << 24);
+  } else if (input_bits <= 24) {
+    return (int32_t) ((uint32_t) input[0] << 8 | (uint32_t) input[1] << 16 | (uint32_t) input[2] << 24);
+  }
+  return (int32_t) ((uint32_t) input[0] | (uint32_t) input[1] << 8 | (uint32_t) input[2] << 16 |
+                    (uint32_t) input[3] << 24);
+}
+
+// Converts a linear gain to Q24
+static int32_t fixed_linear_gain(float gain) {
+  // Clamped in double, as INT32_MAX rounds up to 2^31 as a float
+  return (int32_t) std::fmin((double) gain * (1 << FIXED_GAIN_BITS) + 0.5, (double) INT32_MAX);
+}
+
+// Converts a gain in dB to Q24, or returns 0 if the gain is unity and can be skipped
+static int32_t fixed_gain(float gain_db) {
+  if (gain_db == 0.0f) {
+    return 0;
+  }
+  return fixed_linear_gain(powf(10.0f, gain_db / 20.0f));
+}
+
+// Rounds a left-justified value (with headroom) to the specified number of bits and saturates it. Returns true if the
+// value was clipped.
+static inline bool round_saturate(int64_t &value, int shift, int32_t high_clip) {
+  if (shift > 0) {
+    value = (value + ((int64_t) 1 << (shift - 1))) >> shift;
+  }
+  if (value > high_clip) {
+    value = high_clip;
+    return true;
+  } else if (value < ~high_clip) {
+    value = ~high_clip;
+    return true;
+  }
+  return false;
+}
+
+// Writes a left-justified 32-bit value as a quantized sample with the specified number of bits. Returns true if the
+// value was clipped. The output pointer is advanced past the sample.
+static inline bool write_quantized(int32_t input, uint8_t *&output, uint8_t output_bits) {
+  int64_t value = input;
+  int32_t high_clip = (int32_t) (((int64_t) 1 << (output_bits - 1)) - 1);
+  bool clipped = round_saturate(value, 32 - output_bits, high_clip);
+  int32_t output_value = (int32_t) ((uint32_t) value << ((32 - output_bits) % 8));
+
+  if (output_bits <= 8) {
+    *output++ = (uint8_t) (output_value + 128);
+    return clipped;
+  }
+
+  *output++ = (uint8_t) output_value;
+  *output++ = (uint8_t) (output_value >> 8);
+  if (output_bits > 16) {
+    *output++ = (uint8_t) (output_value >> 16);
+  }
+  if (output_bits > 24) {
+    *output++ = (uint8_t) (output_value >> 24);
+  }
+  return clipped;
+}
+
 void quantized_to_float(const uint8_t *input_buffer, float *output_buffer, uint32_t num_samples, uint8_t input_bits,
                         float gain_db) {
   float gain = powf(10.0f, gain_db / 20.0f);
@@ -40,7 +113,7 @@ void quantized_to_float(const uint8_t *input_buffer, float *output_buffer, uint3
     for (i = j = 0; i < num_samples; ++i) {
       int32_t value = input_buffer[j++];
       value += input_buffer[j++] << 8;
-      value += (int32_t) (signed char) input_buffer[j++] << 16;
+      value += input_buffer[j++] << 16;
       value += (int32_t) (signed char) input_buffer[j++] << 24;
       output_buffer[i] = value * gain_factor;
     }
@@ -93,5 +166,220 @@ uint32_t float_to_quantized(const float *input_buffer, uint8_t *output_buffer, u
   return clipped_samples;
 }
 
+uint32_t quantized_to_fixed16(const uint8_t *input_buffer, int16_t *output_buffer, uint32_t num_samples,
+                              uint8_t input_bits, float gain_db) {
+  const uint32_t bytes_per_sample = (input_bits + 7) / 8;
+  const int32_t gain = fixed_gain(gain_db);
+  uint32_t clipped_samples = 0;
+
+  for (uint32_t i = 0; i < num_samples; ++i, input_buffer += bytes_per_sample) {
+    int64_t value = read_quantized(input_buffer, input_bits);
+    int shift = 16;
+
+    if (gain) {
+      value *= gain;
+      shift += FIXED_GAIN_BITS;
+    }
+
+    clipped_samples += round_saturate(value, shift, INT16_MAX);
+    output_buffer[i] = (int16_t) value;
+  }
+
+  return clipped_samples;
+}
+
+uint32_t quantized_to_fixed32(const uint8_t *input_buffer, int32_t *output_buffer, uint32_t num_samples,
+                              uint8_t input_bits, float gain_db) {
+  const uint32_t bytes_per_sample = (input_bits + 7) / 8;
+  const int32_t gain = fixed_gain(gain_db);
+  uint32_t clipped_samples = 0;
+
+  for (uint32_t i = 0; i < num_samples; ++i, input_buffer += bytes_per_sample) {
+    int64_t value = read_quantized(input_buffer, input_bits);
+
+    if (gain) {
+      value *= gain;
+      clipped_samples += round_saturate(value, FIXED_GAIN_BITS, INT32_MAX);
+    }
+
+    output_buffer[i] = (int32_t) value;
+  }
+
+  return clipped_samples;
+}
+
+uint32_t fixed16_to_quantized(const int16_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                              uint8_t output_bits) {
+  uint32_t clipped_samples = 0;
+
+  for (uint32_t i = 0; i < num_samples; ++i) {
+    clipped_samples += write_quantized((int32_t) ((uint32_t) (uint16_t) input_buffer[i] << 16), output_buffer,
+                                       output_bits);
+  }
+
+  return clipped_samples;
+}
+
+uint32_t fixed32_to_quantized(const int32_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                              uint8_t output_bits) {
+  uint32_t clipped_samples = 0;
+
+  for (uint32_t i = 0; i < num_samples; ++i) {
+    clipped_samples += write_quantized(input_buffer[i], output_buffer, output_bits);
+  }
+
+  return clipped_samples;
+}
+
+// Applies a Q24 gain to a left-justified value and rounds it to the output bits in one step, leaving nothing for
+// write_quantized() to round. Returns true if the value was clipped.
+static inline bool scale_quantized(int32_t &value, int32_t gain, uint8_t output_bits, int32_t high_clip) {
+  int64_t scaled = (int64_t) value * gain;
+  bool clipped = round_saturate(scaled, FIXED_GAIN_BITS + 32 - output_bits, high_clip);
+  value = (int32_t) ((uint32_t) scaled << (32 - output_bits));
+  return clipped;
+}
+
+// Converts samples between any two formats, applying a Q24 gain if it's not zero. Inlined with constant sample sizes
+// by convert_quantized() below, so the common formats get loops without any per-sample format branches.
+static inline uint32_t convert_samples(const uint8_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                                       uint8_t input_bits, uint8_t output_bits, int32_t gain) {
+  const uint32_t bytes_per_sample = (input_bits + 7) / 8;
+  const int32_t high_clip = (int32_t) (((int64_t) 1 << (output_bits - 1)) - 1);
+  uint32_t clipped_samples = 0;
+
+  for (uint32_t i = 0; i < num_samples; ++i, input_buffer += bytes_per_sample) {
+    int32_t value = read_quantized(input_buffer, input_bits);
+
+    if (gain) {
+      clipped_samples += scale_quantized(value, gain, output_bits, high_clip);
+    }
+
+    clipped_samples += write_quantized(value, output_buffer, output_bits);
+  }
+
+  return clipped_samples;
+}
+
+template<uint8_t INPUT_BITS, uint8_t OUTPUT_BITS>
+static uint32_t convert_quantized(const uint8_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                                  int32_t gain) {
+  return convert_samples(input_buffer, output_buffer, num_samples, INPUT_BITS, OUTPUT_BITS, gain);
+}
+
+template<uint8_t INPUT_BITS>
+static uint32_t convert_quantized(const uint8_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                                  uint8_t output_bits, int32_t gain) {
+  switch (output_bits) {
+    case 8:
+      return convert_quantized<INPUT_BITS, 8>(input_buffer, output_buffer, num_samples, gain);
+    case 16:
+      return convert_quantized<INPUT_BITS, 16>(input_buffer, output_buffer, num_samples, gain);
+    case 24:
+      return convert_quantized<INPUT_BITS, 24>(input_buffer, output_buffer, num_samples, gain);
+    case 32:
+      return convert_quantized<INPUT_BITS, 32>(input_buffer, output_buffer, num_samples, gain);
+    default:
+      return convert_samples(input_buffer, output_buffer, num_samples, INPUT_BITS, output_bits, gain);
+  }
+}
+
+uint32_t quantized_to_quantized(const uint8_t *input_buffer, uint8_t *output_buffer, uint32_t num_samples,
+                                uint8_t input_bits, uint8_t output_bits, float gain_db) {
+  const int32_t gain = fixed_gain(gain_db);
+
+  if (!gain && (input_bits == output_bits)) {
+    memcpy(output_buffer, input_buffer, num_samples * ((input_bits + 7) / 8));
+    return 0;
+  }
+
+  switch (input_bits) {
+    case 8:
+      return convert_quantized<8>(input_buffer, output_buffer, num_samples, output_bits, gain);
+    case 16:
+      return convert_quantized<16>(input_buffer, output_buffer, num_samples, output_bits, gain);
+    case 24:
+      return convert_quantized<24>(input_buffer, output_buffer, num_samples, output_bits, gain);
+    case 32:
+      return convert_quantized<32>(input_buffer, output_buffer, num_samples, output_bits, gain);
+    default:
+      return convert_samples(input_buffer, output_buffer, num_samples, input_bits, output_bits, gain);
+  }
+}
+
+// The conversions with a gain ramp apply the gain of each frame as they convert it. A steady gain of 1 takes the
+// conversions above instead, which have loops without the gain for the common formats.
+
+void quantized_to_float(const uint8_t *input_buffer, float *output_buffer, uint32_t num_frames, uint8_t input_bits,
+                        gain::GainRamp &ramp) {
+  const uint8_t channels = ramp.channels();
+
+  if (!ramp.is_ramping() && (ramp.get_gain() == 1.0f)) {
+    quantized_to_float(input_buffer, output_buffer, num_frames * channels, input_bits, 0.0f);
+    return;
+  }
+
+  const uint32_t bytes_per_sample = (input_bits + 7) / 8;
+
+  ramp.for_each_frame(num_frames, [&](size_t frame, float gain) {
+    const float gain_factor = gain / 2147483648.0f;
+    float *output = output_buffer + frame * channels;
+
+    for (uint8_t channel = 0; channel < channels; ++channel, input_buffer += bytes_per_sample) {
+      output[channel] = read_quantized(input_buffer, input_bits) * gain_factor;
+    }
+  });
+}
+
+uint32_t quantized_to_fixed16(const uint8_t *input_buffer, int16_t *output_buffer, uint32_t num_frames,
+                              uint8_t input_bits, gain::GainRamp &ramp) {
+  const uint8_t channels = ramp.channels();
+
+  if (!ramp.is_ramping() && (ramp.get_gain() == 1.0f)) {
+    return quantized_to_fixed16(input_buffer, output_buffer, num_frames * channels, input_bits, 0.0f);
+  }
+
+  const uint32_t bytes_per_sample = (input_bits + 7) / 8;
+  uint32_t clipped_samples = 0;
+
+  ramp.for_each_frame(num_frames, [&](size_t frame, float gain) {
+    const int32_t fixed = fixed_linear_gain(gain);
+    int16_t *output = output_buffer + frame * channels;
+
+    for (uint8_t channel = 0; channel < channels; ++channel, input_buffer += bytes_per_sample) {
+      int64_t value = (int64_t) read_quantized(input_buffer, input_bits) * fixed;
+      clipped_samples += round_saturate(value, 16 + FIXED_GAIN_BITS, INT16_MAX);
+      output[channel] = (int16_t) value;
+    }
+  });
+
+  return clipped_samples;
+}
+
+uint32_t quantized_to_quantized(const uint8_t *input_buffer, uint8_t *output_buffer, uint32_t num_frames,
+                                uint8_t input_bits, uint8_t output_bits, gain::GainRamp &ramp) {
+  const uint8_t channels = ramp.channels();
+
+  if (!ramp.is_ramping() && (ramp.get_gain() == 1.0f)) {
+    return quantized_to_quantized(input_buffer, output_buffer, num_frames * channels, input_bits, output_bits, 0.0f);
+  }
+
+  const uint32_t bytes_per_sample = (input_bits + 7) / 8;
+  const int32_t high_clip = (int32_t) (((int64_t) 1 << (output_bits - 1)) - 1);
+  uint32_t clipped_samples = 0;
+
+  ramp.for_each_frame(num_frames, [&](size_t /*frame*/, float gain) {
+    const int32_t fixed = fixed_linear_gain(gain);
+
+    for (uint8_t channel = 0; channel < channels; ++channel, input_buffer += bytes_per_sample) {
+      int32_t value = read_quantized(input_buffer, input_bits);
+      clipped_samples += scale_quantized(value, fixed, output_bits, high_clip);
+      clipped_samples += write_quantized(value, output_buffer, output_bits);
+    }
+  });
+
+  return clipped_samples;
+}
+
 }  // namespace quantization_utils
 }  // namespace esp_audio_libs
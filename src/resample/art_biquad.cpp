@@ -7,6 +7,17 @@
 ////////////////////////////////////////////////////////////////////////////
 
 #include "art_biquad.h"
+#include "dsp.h"
+
+#include <string.h>
+
+#if defined(__SSE__) && !defined(ESP_PLATFORM)
+#include <xmmintrin.h>
+#define BIQUAD_SSE 1
+#elif (dsps_host_neon_enabled == 1)
+#include <arm_neon.h>
+#define BIQUAD_NEON 1
+#endif
 
 namespace esp_audio_libs {
 namespace art_resampler {
@@ -37,6 +48,64 @@ void biquad_highpass(BiquadCoefficients *filter, double frequency) {
   filter->b2 = (1.0 - K / Q + K * K) * norm;
 }
 
+// Equalizer sections from Robert Bristow-Johnson's Audio EQ Cookbook. The frequency is relative to the sample rate, as
+// above, and q sets the bandwidth (or the slope of a shelf, 0.707 being the steepest without overshoot). They're
+// computed in single precision with one sine, cosine, and power each, so they're cheap enough to update while running.
+
+// Store the cookbook's coefficients, normalized to a0
+
+static void biquad_normalize(BiquadCoefficients *filter, float b0, float b1, float b2, float a0, float a1, float a2) {
+  float norm = 1.0F / a0;
+
+  filter->a0 = b0 * norm;
+  filter->a1 = b1 * norm;
+  filter->a2 = b2 * norm;
+  filter->b1 = a1 * norm;
+  filter->b2 = a2 * norm;
+}
+
+// Peaking (bell) boost or cut around the frequency
+
+void biquad_peaking(BiquadCoefficients *filter, float frequency, float q, float gain_db) {
+  float A = powf(10.0F, gain_db / 40.0F), w0 = 2.0F * (float) M_PI * frequency;
+  float cos_w0 = cosf(w0), alpha = sinf(w0) / (2.0F * q);
+
+  biquad_normalize(filter, 1.0F + alpha * A, -2.0F * cos_w0, 1.0F - alpha * A, 1.0F + alpha / A, -2.0F * cos_w0,
+                   1.0F - alpha / A);
+}
+
+// Boost or cut below the frequency
+
+void biquad_low_shelf(BiquadCoefficients *filter, float frequency, float q, float gain_db) {
+  float A = powf(10.0F, gain_db / 40.0F), w0 = 2.0F * (float) M_PI * frequency;
+  float cos_w0 = cosf(w0), beta = 2.0F * sqrtf(A) * sinf(w0) / (2.0F * q);
+
+  biquad_normalize(filter, A * ((A + 1.0F) - (A - 1.0F) * cos_w0 + beta), 2.0F * A * ((A - 1.0F) - (A + 1.0F) * cos_w0),
+                   A * ((A + 1.0F) - (A - 1.0F) * cos_w0 - beta), (A + 1.0F) + (A - 1.0F) * cos_w0 + beta,
+                   -2.0F * ((A - 1.0F) + (A + 1.0F) * cos_w0), (A + 1.0F) + (A - 1.0F) * cos_w0 - beta);
+}
+
+// Boost or cut above the frequency
+
+void biquad_high_shelf(BiquadCoefficients *filter, float frequency, float q, float gain_db) {
+  float A = powf(10.0F, gain_db / 40.0F), w0 = 2.0F * (float) M_PI * frequency;
+  float cos_w0 = cosf(w0), beta = 2.0F * sqrtf(A) * sinf(w0) / (2.0F * q);
+
+  biquad_normalize(filter, A * ((A + 1.0F) + (A - 1.0F) * cos_w0 + beta),
+                   -2.0F * A * ((A - 1.0F) + (A + 1.0F) * cos_w0), A * ((A + 1.0F) + (A - 1.0F) * cos_w0 - beta),
+                   (A + 1.0F) - (A - 1.0F) * cos_w0 + beta, 2.0F * ((A - 1.0F) - (A + 1.0F) * cos_w0),
+                   (A + 1.0F) - (A - 1.0F) * cos_w0 - beta);
+}
+
+// Notch removing the frequency
+
+void biquad_notch(BiquadCoefficients *filter, float frequency, float q) {
+  float w0 = 2.0F * (float) M_PI * frequency;
+  float cos_w0 = cosf(w0), alpha = sinf(w0) / (2.0F * q);
+
+  biquad_normalize(filter, 1.0F, -2.0F * cos_w0, 1.0F, 1.0F + alpha, -2.0F * cos_w0, 1.0F - alpha);
+}
+
 // Initialize the specified biquad filter with the given parameters. Note that the "gain" parameter is supplied here
 // to save a multiply every time the filter in applied.
 
@@ -50,6 +119,57 @@ void biquad_init(Biquad *f, const BiquadCoefficients *coeffs, float gain) {
   f->first_order = (coeffs->a2 == 0.0F && coeffs->b2 == 0.0F);
 }
 
+// Initialize the specified cascade of biquad filters over the caller's block of num_sections coefficients, using the
+// caller's state block of BIQUAD_CASCADE_STATE_SIZE(num_sections, num_channels) floats, which is cleared.
+
+void biquad_cascade_init(BiquadCascade *f, BiquadCoefficients *coeffs, int num_sections, float *state,
+                         int num_channels) {
+  f->coeffs = coeffs;
+  f->num_sections = num_sections;
+  f->num_channels = num_channels;
+  f->state = state;
+  memset(state, 0, BIQUAD_CASCADE_STATE_SIZE(num_sections, num_channels) * sizeof(float));
+}
+
+// Gain of the recursive half of a direct form II section at DC: the delayed values settle at the input times this
+
+static float biquad_recursion_dc_gain(const BiquadCoefficients *coeffs) {
+  float denominator = 1.0F + coeffs->b1 + coeffs->b2;
+  return (denominator != 0.0F) ? 1.0F / denominator : 0.0F;
+}
+
+// Change the coefficients of one section of the specified cascade while it's running. The delayed values are rescaled
+// to the new recursion, so the output stays continuous as long as the signal is mostly below the cutoff.
+
+void biquad_cascade_set_section(BiquadCascade *f, int section, const BiquadCoefficients *coeffs) {
+  float old_gain = biquad_recursion_dc_gain(&f->coeffs[section]);
+  float new_gain = biquad_recursion_dc_gain(coeffs);
+  float scale = (old_gain != 0.0F) ? new_gain / old_gain : 0.0F;
+  float *w = f->state + 2 * section * f->num_channels;
+
+  for (int i = 0; i < 2 * f->num_channels; ++i)
+    w[i] *= scale;
+
+  f->coeffs[section] = *coeffs;
+}
+
+// Set the state of the specified cascade as if the supplied frame had been held at its input for a long time, so a
+// filter started mid-stream doesn't begin with a step from silence.
+
+void biquad_cascade_prime(BiquadCascade *f, const float *frame) {
+  for (int i = 0; i < f->num_channels; ++i) {
+    float level = frame[i];
+
+    for (int s = 0; s < f->num_sections; ++s) {
+      const BiquadCoefficients *coeffs = &f->coeffs[s];
+      float *w = f->state + 2 * (s * f->num_channels + i);
+
+      w[0] = w[1] = level * biquad_recursion_dc_gain(coeffs);
+      level = (coeffs->a0 + coeffs->a1 + coeffs->a2) * w[0];
+    }
+  }
+}
+
 // Apply the supplied sample to the specified biquad filter, which must have been initialized with biquad_init().
 
 float biquad_apply_sample(Biquad *f, float input) {
@@ -92,5 +212,216 @@ void biquad_apply_buffer(Biquad *f, float *buffer, int num_samples, int stride)
     }
 }
 
+// The esp-dsp kernels take a section's coefficients as an array of five floats, which is how they're laid out
+
+static_assert(sizeof(BiquadCoefficients) == 5 * sizeof(float), "biquad coefficients must be five packed floats");
+
+#if (dsps_biquad_f32_ae32_enabled == 1) || (dsps_biquad_f32_aes3_enabled == 1)
+
+// Frames of each channel gathered at a time for the optimized kernels, which run every section over them while they're
+// in cache
+
+#define BIQUAD_CASCADE_BLOCK_FRAMES 64
+
+// Apply the supplied buffer of interleaved frames to the specified cascade, which must have been initialized with
+// biquad_cascade_init(). A block of each channel is gathered, run through every section, and scattered back before
+// moving on to the next block. Mono buffers go through the block too, since the kernels read past the caller's buffer.
+
+void biquad_cascade_apply_interleaved(BiquadCascade *f, float *buffer, int num_frames) {
+  const int stride = f->num_channels;
+  int s;
+
+  // the kernels read one sample past the end of their input
+  float block[BIQUAD_CASCADE_BLOCK_FRAMES + 1];
+
+  for (int first = 0; first < num_frames; first += BIQUAD_CASCADE_BLOCK_FRAMES) {
+    int frames = num_frames - first < BIQUAD_CASCADE_BLOCK_FRAMES ? num_frames - first : BIQUAD_CASCADE_BLOCK_FRAMES;
+    float *samples = buffer + first * stride;
+
+    for (int i = 0; i < stride; ++i) {
+      for (int j = 0; j < frames; ++j)
+        block[j] = samples[j * stride + i];
+
+      for (s = 0; s < f->num_sections; ++s)
+        dsps_biquad_f32(block, block, frames, (float *) &f->coeffs[s], f->state + 2 * (s * stride + i));
+
+      for (int j = 0; j < frames; ++j)
+        samples[j * stride + i] = block[j];
+    }
+  }
+}
+
+#else
+
+// One sample of each channel of a group, filtered together in the lanes of a SIMD register on hosts with SSE or NEON.
+// The arithmetic of each lane is the same as dsps_biquad_f32_ansi().
+
+#if defined(BIQUAD_SSE)
+#define BIQUAD_CASCADE_LANES 4
+typedef __m128 BiquadLanes;
+static inline BiquadLanes lanes_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void lanes_store(float *p, BiquadLanes v) { _mm_storeu_ps(p, v); }
+static inline BiquadLanes lanes_set(float x) { return _mm_set1_ps(x); }
+static inline BiquadLanes lanes_add(BiquadLanes a, BiquadLanes b) { return _mm_add_ps(a, b); }
+static inline BiquadLanes lanes_sub(BiquadLanes a, BiquadLanes b) { return _mm_sub_ps(a, b); }
+static inline BiquadLanes lanes_mul(BiquadLanes a, BiquadLanes b) { return _mm_mul_ps(a, b); }
+
+// The first lanes of a group short of channels, with the rest zeroed
+static inline BiquadLanes lanes_load_partial(const float *p, int lanes) {
+  if (lanes == 1)
+    return _mm_load_ss(p);
+
+  BiquadLanes pair = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) p);
+  return (lanes == 2) ? pair : _mm_movelh_ps(pair, _mm_load_ss(p + 2));
+}
+
+static inline void lanes_store_partial(float *p, BiquadLanes v, int lanes) {
+  if (lanes == 1) {
+    _mm_store_ss(p, v);
+    return;
+  }
+
+  _mm_storel_pi((__m64 *) p, v);
+  if (lanes == 3)
+    _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+}
+#elif defined(BIQUAD_NEON)
+#define BIQUAD_CASCADE_LANES 4
+typedef float32x4_t BiquadLanes;
+static inline BiquadLanes lanes_load(const float *p) { return vld1q_f32(p); }
+static inline void lanes_store(float *p, BiquadLanes v) { vst1q_f32(p, v); }
+static inline BiquadLanes lanes_set(float x) { return vdupq_n_f32(x); }
+static inline BiquadLanes lanes_add(BiquadLanes a, BiquadLanes b) { return vaddq_f32(a, b); }
+static inline BiquadLanes lanes_sub(BiquadLanes a, BiquadLanes b) { return vsubq_f32(a, b); }
+static inline BiquadLanes lanes_mul(BiquadLanes a, BiquadLanes b) { return vmulq_f32(a, b); }
+
+// The first lanes of a group short of channels, with the rest zeroed
+static inline BiquadLanes lanes_load_partial(const float *p, int lanes) {
+  if (lanes == 1)
+    return vsetq_lane_f32(p[0], vdupq_n_f32(0.0F), 0);
+
+  float32x2_t high = (lanes == 3) ? vset_lane_f32(p[2], vdup_n_f32(0.0F), 0) : vdup_n_f32(0.0F);
+  return vcombine_f32(vld1_f32(p), high);
+}
+
+static inline void lanes_store_partial(float *p, BiquadLanes v, int lanes) {
+  if (lanes == 1) {
+    vst1q_lane_f32(p, v, 0);
+    return;
+  }
+
+  vst1_f32(p, vget_low_f32(v));
+  if (lanes == 3)
+    vst1q_lane_f32(p + 2, v, 2);
+}
+#else
+// Without SIMD each channel is filtered on its own, with its sections in registers
+#define BIQUAD_CASCADE_LANES 1
+typedef float BiquadLanes;
+static inline BiquadLanes lanes_load(const float *p) { return *p; }
+static inline void lanes_store(float *p, BiquadLanes v) { *p = v; }
+static inline BiquadLanes lanes_set(float x) { return x; }
+static inline BiquadLanes lanes_add(BiquadLanes a, BiquadLanes b) { return a + b; }
+static inline BiquadLanes lanes_sub(BiquadLanes a, BiquadLanes b) { return a - b; }
+static inline BiquadLanes lanes_mul(BiquadLanes a, BiquadLanes b) { return a * b; }
+static inline BiquadLanes lanes_load_partial(const float *p, int) { return *p; }
+static inline void lanes_store_partial(float *p, BiquadLanes v, int) { *p = v; }
+#endif
+
+// Sections run together by biquad_cascade_apply_interleaved() in each pass over the buffer
+
+#define BIQUAD_CASCADE_FUSED_SECTIONS 4
+
+// Filter a group of up to BIQUAD_CASCADE_LANES channels of the interleaved buffer through Sections sections,
+// keeping their coefficients and state in registers for the whole buffer. The state of section s for the group's
+// first channel is at state[2 * s * stride]. A group short of channels, like a stereo buffer, runs its spare lanes on
+// silence rather than falling back to one channel at a time.
+
+template<int Sections>
+static void biquad_cascade_apply_group(const BiquadCoefficients *coeffs, float *state, float *samples, int num_frames,
+                                       int stride, int lanes) {
+  BiquadLanes b0[Sections], b1[Sections], b2[Sections], a1[Sections], a2[Sections], w0[Sections], w1[Sections];
+  float delayed[2][BIQUAD_CASCADE_LANES] = {{0.0F}};
+  int i, j, s;
+
+  for (s = 0; s < Sections; ++s) {
+    b0[s] = lanes_set(coeffs[s].a0);
+    b1[s] = lanes_set(coeffs[s].a1);
+    b2[s] = lanes_set(coeffs[s].a2);
+    a1[s] = lanes_set(coeffs[s].b1);
+    a2[s] = lanes_set(coeffs[s].b2);
+
+    for (i = 0; i < lanes; ++i) {
+      delayed[0][i] = state[2 * (s * stride + i)];
+      delayed[1][i] = state[2 * (s * stride + i) + 1];
+    }
+
+    w0[s] = lanes_load(delayed[0]);
+    w1[s] = lanes_load(delayed[1]);
+  }
+
+  for (j = 0; j < num_frames; ++j, samples += stride) {
+    BiquadLanes x = (lanes == BIQUAD_CASCADE_LANES) ? lanes_load(samples) : lanes_load_partial(samples, lanes);
+
+#pragma GCC unroll 4
+    for (s = 0; s < Sections; ++s) {
+      BiquadLanes d0 = lanes_sub(lanes_sub(x, lanes_mul(a1[s], w0[s])), lanes_mul(a2[s], w1[s]));
+      x = lanes_add(lanes_add(lanes_mul(b0[s], d0), lanes_mul(b1[s], w0[s])), lanes_mul(b2[s], w1[s]));
+      w1[s] = w0[s];
+      w0[s] = d0;
+    }
+
+    if (lanes == BIQUAD_CASCADE_LANES)
+      lanes_store(samples, x);
+    else
+      lanes_store_partial(samples, x, lanes);
+  }
+
+  for (s = 0; s < Sections; ++s) {
+    lanes_store(delayed[0], w0[s]);
+    lanes_store(delayed[1], w1[s]);
+
+    for (i = 0; i < lanes; ++i) {
+      state[2 * (s * stride + i)] = delayed[0][i];
+      state[2 * (s * stride + i) + 1] = delayed[1][i];
+    }
+  }
+}
+
+// Apply the supplied buffer of interleaved frames to the specified cascade, which must have been initialized with
+// biquad_cascade_init(). Every section is applied to a frame before the next is read, so the buffer is only walked
+// once for each group of channels and up to BIQUAD_CASCADE_FUSED_SECTIONS sections.
+
+void biquad_cascade_apply_interleaved(BiquadCascade *f, float *buffer, int num_frames) {
+  const int stride = f->num_channels;
+
+  for (int section = 0; section < f->num_sections; section += BIQUAD_CASCADE_FUSED_SECTIONS) {
+    const BiquadCoefficients *coeffs = f->coeffs + section;
+
+    for (int first = 0; first < stride; first += BIQUAD_CASCADE_LANES) {
+      const int lanes = stride - first < BIQUAD_CASCADE_LANES ? stride - first : BIQUAD_CASCADE_LANES;
+      float *state = f->state + 2 * (section * stride + first);
+
+      switch (f->num_sections - section) {
+        case 1:
+          biquad_cascade_apply_group<1>(coeffs, state, buffer + first, num_frames, stride, lanes);
+          break;
+        case 2:
+          biquad_cascade_apply_group<2>(coeffs, state, buffer + first, num_frames, stride, lanes);
+          break;
+        case 3:
+          biquad_cascade_apply_group<3>(coeffs, state, buffer + first, num_frames, stride, lanes);
+          break;
+        default:
+          biquad_cascade_apply_group<BIQUAD_CASCADE_FUSED_SECTIONS>(coeffs, state, buffer + first, num_frames, stride,
+                                                                    lanes);
+          break;
+      }
+    }
+  }
+}
+
+#endif
+
 }  // namespace art_resampler
 }  // namespace esp_audio_libs
\ No newline at end of file
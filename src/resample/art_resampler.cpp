@@ -11,11 +11,94 @@
 #include "dsp.h"
 #include "../memory_utils.h"
 
+#include <algorithm>
+#include <mutex>
+
+#if defined(__SSE__) && !defined(ESP_PLATFORM)
+#include <xmmintrin.h>
+#define RESAMPLE_SSE 1
+#elif (dsps_host_neon_enabled == 1)
+#include <arm_neon.h>
+#define RESAMPLE_NEON 1
+#endif
+
 namespace esp_audio_libs {
 namespace art_resampler {
 
+// Maximum number of output samples planned (and generated) per block by the process functions
+#define RESAMPLE_BLOCK_FRAMES 32
+
+// Maximum number of channels filtered together (sharing the filter tap loads)
+#define RESAMPLE_CHANNEL_GROUP 4
+
+// Alignment of the context's history and of the filter coefficients, in bytes. It's a multiple of the SIMD vector
+// size (the filters are multiples of 4 taps, so each one starts aligned too) and of the ESP32 cache line size.
+#define RESAMPLE_ALIGNMENT 64
+
+#define ALIGNED_SIZE(size) (((size) + RESAMPLE_ALIGNMENT - 1) & ~((size_t) RESAMPLE_ALIGNMENT - 1))
+#define ALIGNED_POINTER(ptr) ((void *) ALIGNED_SIZE((uintptr_t) (ptr)))
+
+// Frames in the history ring: room for the filter window and the new input of a whole block of output samples even
+// when downsampling by 2. The ring is followed by a mirror of its first numTaps - 1 frames, so a window that wraps
+// around the end can still be read contiguously (see mirror_history()).
+#define HISTORY_RING_FRAMES(numTaps) (2 * ((numTaps) + RESAMPLE_BLOCK_FRAMES))
+#define HISTORY_FRAMES(numTaps) (HISTORY_RING_FRAMES(numTaps) + (numTaps) - 1)
+
+// Fixed-point formats: filters are Q30 and the history holds 24-bit samples, so a filtered sample
+// is a Q53 sum in a 64-bit accumulator (with plenty of headroom for filter overshoot)
+#define FIXED_FILTER_BITS 30
+#define FIXED_HISTORY_BITS 24
+
+// Location of one output sample relative to the history, computed once and shared by all channels
+typedef struct {
+  int index;       // history ring frame of the first filter tap
+  int filter;      // index of the (first) sinc filter, or -1 for a direct copy of an input sample
+  float fraction;  // weight of the second filter when interpolating between adjacent filters
+} ResamplePosition;
+
+// A bank of sinc filters shared by all contexts with the same configuration (see acquire_filter_bank())
+struct ResampleFilterBank {
+  int numTaps, numFilters, count, flags;
+  int stored;  // filters 0 to stored - 1 are in coefficients, and the rest are their mirror images
+  float lowpassRatio;
+  float delaySkew;  // mean DC group delay minus the sinc center, in input samples (see resampleGetLatency())
+  int references;
+  void *memory;        // the single allocation holding this structure, the filter pointers, and the coefficients
+  void *coefficients;  // stored * numTaps floats (or Q30 integers), aligned to RESAMPLE_ALIGNMENT
+  void **filters;      // pointers to each stored filter in coefficients
+  ResampleFilterBank *next;
+};
+
+// Context flags that affect the generated filters
+#define FILTER_BANK_FLAGS (BLACKMAN_HARRIS | INCLUDE_LOWPASS | FIXED_POINT | LOW_LATENCY)
+
+// Number of unreferenced filter banks kept for reuse
+#define FILTER_CACHE_IDLE_BANKS 2
+
+static Resample *init_context(void *memory, size_t memorySize, int numChannels, int numTaps, int numFilters,
+                              int upFactor, int downFactor, float lowpassRatio, int flags);
+static int filter_count(Resample *cxt);
+static int stored_filter_count(int numFilters, int count, int flags);
+static ResampleFilterBank *acquire_filter_bank(Resample *cxt, float lowpassRatio);
+static void release_filter_bank(ResampleFilterBank *bank);
+static bool reduce_ratio(int *upFactor, int *downFactor);
+static bool switch_filters(Resample *cxt, int numFilters, int upFactor, int downFactor, float lowpassRatio,
+                           int flags);
 static void init_filter(Resample *cxt, float *filter, float fraction, float lowpass_ratio);
-static float subsample(Resample *cxt, float *source, float offset);
+static float filter_delay_skew(Resample *cxt, const float *filter, float fraction);
+static void quantize_filter(Resample *cxt, const float *filter, int32_t *fixed_filter);
+static ResampleResult process_fixed(Resample *cxt, const int16_t *input16, const int32_t *input32, int numInputFrames,
+                                    int16_t *output16, int32_t *output32, int numOutputFrames, float ratio);
+static bool output_ready(Resample *cxt, int inputLimit);
+static bool prepare_history(Resample *cxt, int numInputFrames);
+static int window_start(Resample *cxt);
+static int history_frame(Resample *cxt, int index);
+static int history_run(Resample *cxt, int index, int count, int *frame);
+static void mirror_history(Resample *cxt, int index, int count);
+static int plan_output(Resample *cxt, ResamplePosition *positions, int numOutputFrames, int numInputFrames, float step,
+                       int *needed);
+static void subsample(Resample *cxt, const ResamplePosition *pos, int channel, int channels, float *output);
+static void subsample_fixed(Resample *cxt, const ResamplePosition *pos, int channel, int channels, int64_t *output);
 
 // Initialize a resampler context with the specified characteristics. The returned context pointer
 // is used for all subsequent calls to the resampler (and should not be dereferenced). A NULL
@@ -52,6 +135,16 @@ static float subsample(Resample *cxt, float *source, float offset);
 //                                - lowpassRatio specifies frequency as a ratio to input samples
 //                                - required for downsampling, optional otherwise
 //
+//   FIXED_POINT:               store Q30 integer filters and a 32-bit integer sample history
+//                                - the context must be used with the integer process functions
+//                                  (resampleProcessInterleavedS16() / resampleProcessInterleavedS32())
+//                                - convolution uses a 64-bit accumulator, for chips with a slow FPU
+//
+//   LOW_LATENCY:               use an asymmetrical window with only a quarter of the taps after
+//                                the sinc maximum, which halves the signal delay (see note 2)
+//                                - the filters are no longer linear phase and have a wider
+//                                  transition band, so the tap count may need to be increased
+//
 // Notes:
 //
 // 1. The same resampling instance can be used for upsampling, downsampling, or simple (near-unity)
@@ -63,10 +156,11 @@ static float subsample(Resample *cxt, float *source, float offset);
 //
 // 2. When the context is initialized (or reset) the sample histories are filled with silence such
 //    that the resampler is ready to generate output immediately. However, this also means that there
-//    is an implicit signal delay equal to half the tap length of the sinc filters in samples. If
-//    zero delay is desired then that many samples can be ignored, or the resampleAdvancePosition()
-//    function can be used to bypass them. Also, at the end of processing an equal length of silence
-//    must be appended to the input audio to align the output with the actual input.
+//    is an implicit signal delay equal to half the tap length of the sinc filters in samples (or a
+//    quarter with LOW_LATENCY, see resampleGetLatency() for the exact value). If zero delay is
+//    desired then that many samples can be ignored, or the resampleAdvancePosition() function can
+//    be used to bypass them. Also, at the end of processing an equal length of silence must be
+//    appended to the input audio to align the output with the actual input.
 //
 // 3. Both the number of interpolation filters and the number of taps per filter directly control
 //    the fidelity of the resampling. The filter length has an approximately linear affect on the
@@ -74,80 +168,418 @@ static float subsample(Resample *cxt, float *source, float offset);
 //    filters themselves and also for the sample history storage). On the other hand, the number
 //    of filters allocated primarily affects just the memory footprint (it has little affect on CPU
 //    load and so can be large on systems with lots of RAM).
+//
+// 4. The filters are read-only once generated, so contexts initialized with the same taps, filter
+//    count, lowpassRatio and window share one copy of them (see resampleFlushFilterCache()). Unless
+//    LOW_LATENCY is specified the window is symmetrical, so only the first half of the filters is
+//    stored and the rest are applied as time-reversed copies of them.
+//
+// 5. The context and its sample history are one allocation (see resampleInitInPlace() to provide it
+//    instead), and each bank of filters is another, both aligned to RESAMPLE_ALIGNMENT bytes. Their
+//    sizes are given by resampleGetContextSize() and resampleGetFilterBankSize().
 
 Resample *resampleInit(int numChannels, int numTaps, int numFilters, float lowpassRatio, int flags) {
-  Resample *cxt = (Resample *) calloc(1, sizeof(Resample));
-  int i;
+  return resampleInitInPlace(NULL, 0, numChannels, numTaps, numFilters, lowpassRatio, flags);
+}
 
-  if (lowpassRatio > 0.0f && lowpassRatio < 1.0f)
-    flags |= INCLUDE_LOWPASS;
-  else {
-    flags &= ~INCLUDE_LOWPASS;
-    lowpassRatio = 1.0f;
+// Initialize a resampler context like resampleInit(), but in the caller's memory (for example a
+// static buffer, or internal RAM instead of PSRAM) rather than allocating it. The memory must be at
+// least resampleGetContextSize() bytes (it needn't be aligned), and it must stay valid until
+// resampleFree() is called, which must still be called to release the filters. If memory is NULL,
+// the context is allocated as with resampleInit().
+
+Resample *resampleInitInPlace(void *memory, size_t memorySize, int numChannels, int numTaps, int numFilters,
+                              float lowpassRatio, int flags) {
+  if (numFilters < 2 || numFilters > 1024) {
+    fprintf(stderr, "must be 2-1024 filters!\n");
+    return NULL;
   }
 
+  return init_context(memory, memorySize, numChannels, numTaps, numFilters, 0, 0, lowpassRatio, flags);
+}
+
+// Initialize a resampler context for an exact rational ratio of upFactor / downFactor (for example
+// 160 / 147 for 44.1 kHz to 48 kHz). Instead of a floating-point output offset, the position is kept
+// as an integer sample index and phase (in units of 1 / upFactor input samples), so there is no
+// accumulated drift over long streams. Exactly one sinc filter is generated for each phase, so every
+// output sample is a single dot product and the SUBSAMPLE_INTERPOLATE flag is ignored. The "ratio"
+// parameter of the process and query functions is also ignored for these contexts. The parameters
+// are the same as resampleInit() except:
+//
+// upFactor:        the numerator of the ratio (output samples per period), which is also the number
+//                  of sinc filters generated
+//                    - must be 1 - 1024
+//
+// downFactor:      the denominator of the ratio (input samples per period)
+//                    - must be at least 1
+//
+// The ratio is reduced to lowest terms, so any equivalent pair of factors may be given.
+
+Resample *resampleInitRational(int numChannels, int numTaps, int upFactor, int downFactor, float lowpassRatio,
+                               int flags) {
+  return resampleInitRationalInPlace(NULL, 0, numChannels, numTaps, upFactor, downFactor, lowpassRatio, flags);
+}
+
+// Initialize a rational ratio context in the caller's memory (see resampleInitInPlace())
+
+Resample *resampleInitRationalInPlace(void *memory, size_t memorySize, int numChannels, int numTaps, int upFactor,
+                                      int downFactor, float lowpassRatio, int flags) {
+  if (!reduce_ratio(&upFactor, &downFactor))
+    return NULL;
+
+  return init_context(memory, memorySize, numChannels, numTaps, upFactor, upFactor, downFactor, lowpassRatio,
+                      flags & ~SUBSAMPLE_INTERPOLATE);
+}
+
+// Return the number of bytes of memory needed for a context with the specified number of channels
+// and taps, including its sample history and the slack needed to align it
+
+size_t resampleGetContextSize(int numChannels, int numTaps) {
+  return RESAMPLE_ALIGNMENT - 1 + ALIGNED_SIZE(sizeof(Resample)) +
+         (size_t) HISTORY_FRAMES(numTaps) * numChannels * sizeof(float);
+}
+
+// Return the number of bytes allocated for a bank of filters with the specified number of taps,
+// filters (the numFilters given to resampleInit(), or for a rational context, an upFactor that's
+// nonzero) and flags. Contexts with the same filters share one bank (see note 4 above).
+
+size_t resampleGetFilterBankSize(int numTaps, int numFilters, int upFactor, int flags) {
+  int count = stored_filter_count(upFactor ? upFactor : numFilters, upFactor ? upFactor : numFilters + 1, flags);
+
+  return RESAMPLE_ALIGNMENT - 1 + ALIGNED_SIZE(sizeof(ResampleFilterBank) + count * sizeof(void *)) +
+         (size_t) count * numTaps * sizeof(float);
+}
+
+static Resample *init_context(void *memory, size_t memorySize, int numChannels, int numTaps, int numFilters,
+                              int upFactor, int downFactor, float lowpassRatio, int flags) {
+  Resample *cxt;
+  void *allocated = NULL;
+
   if ((numTaps & 3) || numTaps <= 0 || numTaps > 1024) {
     fprintf(stderr, "must 4-1024 filter taps, and a multiple of 4!\n");
     return NULL;
   }
 
-  if (numFilters < 2 || numFilters > 1024) {
-    fprintf(stderr, "must be 2-1024 filters!\n");
+  if (memory == NULL)
+    memory = allocated = internal::alloc_psram_fallback(resampleGetContextSize(numChannels, numTaps));
+  else if (memorySize < resampleGetContextSize(numChannels, numTaps)) {
+    fprintf(stderr, "context memory must be at least resampleGetContextSize() bytes!\n");
+    return NULL;
+  }
+
+  if (memory == NULL)
     return NULL;
+
+  // the history follows the context, both aligned
+  cxt = (Resample *) ALIGNED_POINTER(memory);
+  memset(cxt, 0, sizeof(Resample));
+  cxt->memory = allocated;
+  cxt->history = (float *) ((char *) cxt + ALIGNED_SIZE(sizeof(Resample)));
+
+  if (lowpassRatio > 0.0f && lowpassRatio < 1.0f)
+    flags |= INCLUDE_LOWPASS;
+  else {
+    flags &= ~INCLUDE_LOWPASS;
+    lowpassRatio = 1.0f;
   }
 
   cxt->numChannels = numChannels;
-  cxt->numSamples = numTaps * 16;
+  cxt->numSamples = HISTORY_RING_FRAMES(numTaps);
   cxt->numFilters = numFilters;
   cxt->numTaps = numTaps;
   cxt->flags = flags;
+  cxt->upFactor = upFactor;
+  cxt->downFactor = downFactor;
+  cxt->lookahead = (flags & LOW_LATENCY) ? numTaps / 4 : numTaps / 2;
+
+  cxt->filterBank = acquire_filter_bank(cxt, lowpassRatio);
+
+  if (cxt->filterBank == NULL) {
+    resampleFree(cxt);
+    return NULL;
+  }
+
+  cxt->filters = (float **) cxt->filterBank->filters;
+  memset(cxt->history, 0, HISTORY_FRAMES(numTaps) * numChannels * sizeof(float));
+
+  cxt->outputOffset = cxt->outputIndex = numTaps - cxt->lookahead;
+  cxt->inputIndex = numTaps;
+
+  return cxt;
+}
+
+// Filters are generated at fractions 0 through 1 inclusive (i.e., one more than the specified number),
+// except in rational mode where only the fractions of the upFactor phases are needed.
+
+static int filter_count(Resample *cxt) { return cxt->upFactor ? cxt->numFilters : cxt->numFilters + 1; }
+
+// With a symmetrical window the filter at fraction f is the filter at 1 - f reversed in time, so filter i is
+// filter numFilters - i reversed. Only the filters up to fraction 0.5 are stored, and the others are applied by
+// reading their mirror images backwards (see apply_bank_filter()). The asymmetrical LOW_LATENCY filters are all
+// stored.
 
-  // note that we actually have one more than the specified number of filters
-  cxt->filters = (float **) calloc(cxt->numFilters + 1, sizeof(float *));
+static int stored_filter_count(int numFilters, int count, int flags) {
+  return (flags & LOW_LATENCY) ? count : std::min(count, numFilters / 2 + 1);
+}
+
+// The sinc filters depend only on the tap count, the filter fractions, the lowpass ratio and the
+// window, so contexts with the same configuration share a single read-only bank. Banks live in a
+// process-wide list guarded by a mutex and are reference counted by the contexts using them. The
+// most recently released banks (up to FILTER_CACHE_IDLE_BANKS) are kept unreferenced so that tearing
+// down a resampler and creating an identical one, or switching a context back and forth between two
+// rates with resampleSetFilters(), does not regenerate the filters. Older unreferenced banks are freed
+// when a bank with a different configuration has to be generated, and all of them are freed by
+// calling resampleFlushFilterCache().
+
+static ResampleFilterBank *filter_banks;
+static std::mutex filter_bank_mutex;
+
+static void free_filter_bank(ResampleFilterBank *bank) { internal::free_psram_fallback(bank->memory); }
+
+// Free all but the first "keep" unreferenced banks, which are the most recently released ones since
+// banks move to the head of the list when released (filter_bank_mutex must be held)
+
+static void flush_filter_banks(int keep) {
+  ResampleFilterBank **link = &filter_banks;
 
-  cxt->tempFilter = (float *) internal::alloc_psram_fallback(numTaps * sizeof(float));
+  while (*link) {
+    ResampleFilterBank *bank = *link;
 
-  if (cxt->tempFilter == nullptr) {
+    if (bank->references == 0 && keep-- <= 0) {
+      *link = bank->next;
+      free_filter_bank(bank);
+    } else
+      link = &bank->next;
+  }
+}
+
+// The bank is a single allocation: the structure, then the filter pointers, then the coefficients of
+// the stored filters (both representations are 4 bytes per coefficient), aligned to RESAMPLE_ALIGNMENT.
+// Fixed-point filters are generated in floating-point first (in the second half of the scratch
+// buffer) and then quantized.
+
+static ResampleFilterBank *build_filter_bank(Resample *cxt, float lowpassRatio) {
+  int count = filter_count(cxt), stored = stored_filter_count(cxt->numFilters, count, cxt->flags);
+  int scratch_taps = (cxt->flags & FIXED_POINT) ? cxt->numTaps * 2 : cxt->numTaps;
+  void *memory = internal::alloc_psram_fallback(resampleGetFilterBankSize(cxt->numTaps, cxt->numFilters,
+                                                                          cxt->upFactor, cxt->flags));
+  float *scratch = (float *) internal::alloc_psram_fallback(scratch_taps * sizeof(float));
+  float *float_filter = (cxt->flags & FIXED_POINT) ? scratch + cxt->numTaps : NULL;
+  ResampleFilterBank *bank;
+  int i;
+
+  if (memory == NULL || scratch == NULL) {
+    internal::free_psram_fallback(memory);
+    internal::free_psram_fallback(scratch);
     return NULL;
   }
 
-  for (i = 0; i <= cxt->numFilters; ++i) {
-    cxt->filters[i] = (float *) internal::alloc_psram_fallback(cxt->numTaps * sizeof(float));
-    if (cxt->filters[i] == nullptr) {
-      return NULL;
+  bank = (ResampleFilterBank *) ALIGNED_POINTER(memory);
+  memset(bank, 0, sizeof(ResampleFilterBank));
+  bank->memory = memory;
+  bank->filters = (void **) (bank + 1);
+  bank->coefficients = (char *) bank + ALIGNED_SIZE(sizeof(ResampleFilterBank) + stored * sizeof(void *));
+
+  bank->numTaps = cxt->numTaps;
+  bank->numFilters = cxt->numFilters;
+  bank->count = count;
+  bank->stored = stored;
+  bank->flags = cxt->flags & FILTER_BANK_FLAGS;
+  bank->lowpassRatio = lowpassRatio;
+  cxt->tempFilter = scratch;
+
+  for (i = 0; i < bank->stored; ++i) {
+    float fraction = (float) i / cxt->numFilters, skew;
+    int mirror = cxt->numFilters - i;
+
+    if (cxt->flags & FIXED_POINT) {
+      int32_t *filter = (int32_t *) bank->coefficients + i * bank->numTaps;
+
+      init_filter(cxt, float_filter, fraction, lowpassRatio);
+      skew = filter_delay_skew(cxt, float_filter, fraction);
+      quantize_filter(cxt, float_filter, filter);
+      bank->filters[i] = filter;
+    } else {
+      float *filter = (float *) bank->coefficients + i * bank->numTaps;
+
+      init_filter(cxt, filter, fraction, lowpassRatio);
+      skew = filter_delay_skew(cxt, filter, fraction);
+      bank->filters[i] = filter;
     }
-    memset(cxt->filters[i], 0, cxt->numTaps * sizeof(float));
-    init_filter(cxt, cxt->filters[i], (float) i / cxt->numFilters, lowpassRatio);
+
+    // the delay skew of a mirror image is the negative of the stored filter's
+    bank->delaySkew += skew / bank->count;
+
+    if (mirror >= bank->stored && mirror < bank->count)
+      bank->delaySkew -= skew / bank->count;
   }
 
-  internal::free_psram_fallback(cxt->tempFilter);
+  internal::free_psram_fallback(scratch);
   cxt->tempFilter = NULL;
-  cxt->buffers = (float **) calloc(numChannels, sizeof(float *));
 
-  for (i = 0; i < numChannels; ++i) {
-    cxt->buffers[i] = (float *) internal::alloc_psram_fallback(cxt->numSamples * sizeof(float));
-    if (cxt->buffers[i] == nullptr) {
-      return NULL;
+  return bank;
+}
+
+// Return a referenced bank of filters for the context, generating it only if no existing bank matches
+
+static ResampleFilterBank *acquire_filter_bank(Resample *cxt, float lowpassRatio) {
+  std::lock_guard<std::mutex> lock(filter_bank_mutex);
+  ResampleFilterBank *bank;
+
+  for (bank = filter_banks; bank; bank = bank->next)
+    if (bank->numTaps == cxt->numTaps && bank->numFilters == cxt->numFilters && bank->count == filter_count(cxt) &&
+        bank->flags == (cxt->flags & FILTER_BANK_FLAGS) && bank->lowpassRatio == lowpassRatio) {
+      bank->references++;
+      return bank;
     }
-    memset(cxt->buffers[i], 0, cxt->numSamples * sizeof(float));
+
+  flush_filter_banks(FILTER_CACHE_IDLE_BANKS - 1);
+  bank = build_filter_bank(cxt, lowpassRatio);
+
+  if (bank) {
+    bank->references = 1;
+    bank->next = filter_banks;
+    filter_banks = bank;
   }
 
-  cxt->outputOffset = numTaps / 2;
-  cxt->inputIndex = numTaps;
+  return bank;
+}
 
-  return cxt;
+static void release_filter_bank(ResampleFilterBank *bank) {
+  std::lock_guard<std::mutex> lock(filter_bank_mutex);
+
+  if (--bank->references == 0 && filter_banks != bank) {
+    ResampleFilterBank **link = &filter_banks;
+
+    while (*link != bank)
+      link = &(*link)->next;
+
+    *link = bank->next;
+    bank->next = filter_banks;
+    filter_banks = bank;
+  }
+}
+
+// Free the cached filter banks that are no longer used by any resampler context (the banks of live
+// contexts are unaffected). This can be used to reclaim memory once resampling has stopped.
+
+void resampleFlushFilterCache(void) {
+  std::lock_guard<std::mutex> lock(filter_bank_mutex);
+
+  flush_filter_banks(0);
+}
+
+// Reduce a rational ratio to lowest terms and check that it can be used (returns false if not)
+
+static bool reduce_ratio(int *upFactor, int *downFactor) {
+  int a = *upFactor, b = *downFactor;
+
+  while (b > 0) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+
+  if (a > 1) {
+    *upFactor /= a;
+    *downFactor /= a;
+  }
+
+  if (*upFactor < 1 || *upFactor > 1024 || *downFactor < 1) {
+    fprintf(stderr, "must be 1-1024 phases and a positive denominator!\n");
+    return false;
+  }
+
+  return true;
+}
+
+// Switch a context to a different set of sinc filters without disturbing its sample history, so the
+// ratio and lowpass can be changed mid-stream without a gap (for example, on a track change between
+// 44.1 kHz and 48 kHz content). resampleSetFilters() selects a floating-point position with numFilters
+// filters (as with resampleInit()) and resampleSetFiltersRational() an exact upFactor / downFactor
+// ratio (as with resampleInitRational()), and either can be applied to a context created by either
+// initializer. The position carries over, rounded to the nearest phase when switching to a rational
+// ratio. The filters are taken from the shared cache when possible, so switching back and forth between
+// two configurations doesn't allocate once both have been used. The FIXED_POINT flag of the context
+// can't be changed. Returns false (and leaves the context unchanged) if the parameters are invalid or
+// the filters can't be allocated.
+
+bool resampleSetFilters(Resample *cxt, int numFilters, float lowpassRatio, int flags) {
+  if (numFilters < 2 || numFilters > 1024) {
+    fprintf(stderr, "must be 2-1024 filters!\n");
+    return false;
+  }
+
+  return switch_filters(cxt, numFilters, 0, 0, lowpassRatio, flags);
+}
+
+bool resampleSetFiltersRational(Resample *cxt, int upFactor, int downFactor, float lowpassRatio, int flags) {
+  if (!reduce_ratio(&upFactor, &downFactor))
+    return false;
+
+  return switch_filters(cxt, upFactor, upFactor, downFactor, lowpassRatio, flags & ~SUBSAMPLE_INTERPOLATE);
+}
+
+static bool switch_filters(Resample *cxt, int numFilters, int upFactor, int downFactor, float lowpassRatio,
+                           int flags) {
+  Resample next = *cxt;
+  ResampleFilterBank *bank;
+  double position;
+
+  if (lowpassRatio > 0.0f && lowpassRatio < 1.0f)
+    flags |= INCLUDE_LOWPASS;
+  else {
+    flags &= ~INCLUDE_LOWPASS;
+    lowpassRatio = 1.0f;
+  }
+
+  next.numFilters = numFilters;
+  next.upFactor = upFactor;
+  next.downFactor = downFactor;
+  next.flags = (flags & ~(FIXED_POINT | LOW_LATENCY)) | (cxt->flags & (FIXED_POINT | LOW_LATENCY));
+  next.tempFilter = NULL;
+
+  bank = acquire_filter_bank(&next, lowpassRatio);
+
+  if (bank == NULL)
+    return false;
+
+  // carry the position (in history samples) over into the representation of the new ratio
+
+  if (cxt->upFactor)
+    position = cxt->outputIndex + (double) cxt->outputPhase / cxt->upFactor;
+  else
+    position = cxt->outputOffset;
+
+  if (upFactor) {
+    next.outputIndex = (int) floor(position);
+    next.outputPhase = (int) floor((position - next.outputIndex) * upFactor + 0.5);
+
+    if (next.outputPhase == upFactor) {
+      next.outputPhase = 0;
+      next.outputIndex++;
+    }
+  } else {
+    next.outputOffset = position;
+    next.outputPhase = 0;
+  }
+
+  release_filter_bank(cxt->filterBank);
+  next.filterBank = bank;
+  next.filters = (float **) bank->filters;
+  *cxt = next;
+
+  return true;
 }
 
 // Reset a resampler context to its initialized state. Specifically, any history is discarded
 // and this should be used when an audio "flush" or other discontinuity occurs.
 
 void resampleReset(Resample *cxt) {
-  int i;
+  memset(cxt->history, 0, HISTORY_FRAMES(cxt->numTaps) * cxt->numChannels * sizeof(float));
 
-  for (i = 0; i < cxt->numChannels; ++i)
-    memset(cxt->buffers[i], 0, cxt->numSamples * sizeof(float));
-
-  cxt->outputOffset = cxt->numTaps / 2;
+  cxt->outputOffset = cxt->outputIndex = cxt->numTaps - cxt->lookahead;
+  cxt->outputPhase = 0;
   cxt->inputIndex = cxt->numTaps;
 }
 
@@ -160,42 +592,58 @@ void resampleReset(Resample *cxt) {
 // resampling proceeds until EITHER the input is exhausted or space at the output is exhausted
 // (there is no other limit).
 //
+// Processing is done in blocks: the filter positions for a run of output samples are computed
+// first, then all the input those outputs require is appended to the history in one pass, and
+// finally the outputs are generated in a tight loop. The results (and the number of samples
+// consumed and generated) are identical to processing one sample at a time.
+//
 // This is the "non-interleaved" version of the resampler where the audio sample buffers for
 // different channels are passed in as an array of float pointers. There is also an
 // "interleaved" version (see below).
 
 ResampleResult resampleProcess(Resample *cxt, const float *const *input, int numInputFrames, float *const *output,
                                int numOutputFrames, float ratio) {
-  int half_taps = cxt->numTaps / 2, i;
-  ResampleResult res = {0, 0};
+  ResamplePosition positions[RESAMPLE_BLOCK_FRAMES];
+  float step = 1.0f / ratio;
+  ResampleResult res = {0, 0, 0};
+  int frames, needed, run, frame, i, j, k;
 
   while (numOutputFrames > 0) {
-    if (cxt->outputOffset >= cxt->inputIndex - half_taps) {
-      if (numInputFrames > 0) {
-        if (cxt->inputIndex == cxt->numSamples) {
-          for (i = 0; i < cxt->numChannels; ++i)
-            memmove(cxt->buffers[i], cxt->buffers[i] + cxt->numSamples - cxt->numTaps, cxt->numTaps * sizeof(float));
-
-          cxt->outputOffset -= cxt->numSamples - cxt->numTaps;
-          cxt->inputIndex -= cxt->numSamples - cxt->numTaps;
-        }
+    if (!prepare_history(cxt, numInputFrames))
+      break;
 
-        for (i = 0; i < cxt->numChannels; ++i)
-          cxt->buffers[i][cxt->inputIndex] = input[i][res.input_used];
+    frames = plan_output(cxt, positions, numOutputFrames, numInputFrames, step, &needed);
 
-        cxt->inputIndex++;
-        res.input_used++;
-        numInputFrames--;
-      } else
-        break;
-    } else {
-      for (i = 0; i < cxt->numChannels; ++i)
-        output[i][res.output_generated] = subsample(cxt, cxt->buffers[i], cxt->outputOffset);
+    for (k = 0; k < needed; k += run) {
+      run = history_run(cxt, cxt->inputIndex + k, needed - k, &frame);
+
+      for (i = 0; i < cxt->numChannels; ++i) {
+        const float *src = input[i] + res.input_used + k;
+        float *dst = cxt->history + frame * cxt->numChannels + i;
 
-      cxt->outputOffset += (1.0f / ratio);
-      res.output_generated++;
-      numOutputFrames--;
+        for (j = 0; j < run; ++j, dst += cxt->numChannels)
+          *dst = src[j];
+      }
     }
+
+    mirror_history(cxt, cxt->inputIndex, needed);
+    cxt->inputIndex += needed;
+    res.input_used += needed;
+    numInputFrames -= needed;
+
+    for (j = 0; j < frames; ++j)
+      for (i = 0; i < cxt->numChannels; i += RESAMPLE_CHANNEL_GROUP) {
+        int channels = std::min(cxt->numChannels - i, RESAMPLE_CHANNEL_GROUP);
+        float samples[RESAMPLE_CHANNEL_GROUP];
+
+        subsample(cxt, &positions[j], i, channels, samples);
+
+        for (k = 0; k < channels; ++k)
+          output[i + k][res.output_generated + j] = samples[k];
+      }
+
+    res.output_generated += frames;
+    numOutputFrames -= frames;
   }
 
   return res;
@@ -207,41 +655,54 @@ ResampleResult resampleProcess(Resample *cxt, const float *const *input, int num
 
 ResampleResult resampleProcessInterleaved(Resample *cxt, const float *input, int numInputFrames, float *output,
                                           int numOutputFrames, float ratio) {
-  int half_taps = cxt->numTaps / 2, i;
-  ResampleResult res = {0, 0};
+  ResamplePosition positions[RESAMPLE_BLOCK_FRAMES];
+  float step = 1.0f / ratio;
+  ResampleResult res = {0, 0, 0};
+  int frames, needed, run, frame, i, j;
 
   while (numOutputFrames > 0) {
-    if (cxt->outputOffset >= cxt->inputIndex - half_taps) {
-      if (numInputFrames > 0) {
-        if (cxt->inputIndex == cxt->numSamples) {
-          for (i = 0; i < cxt->numChannels; ++i)
-            memmove(cxt->buffers[i], cxt->buffers[i] + cxt->numSamples - cxt->numTaps, cxt->numTaps * sizeof(float));
-
-          cxt->outputOffset -= cxt->numSamples - cxt->numTaps;
-          cxt->inputIndex -= cxt->numSamples - cxt->numTaps;
-        }
+    if (!prepare_history(cxt, numInputFrames))
+      break;
 
-        for (i = 0; i < cxt->numChannels; ++i)
-          cxt->buffers[i][cxt->inputIndex] = *input++;
-
-        cxt->inputIndex++;
-        res.input_used++;
-        numInputFrames--;
-      } else
-        break;
-    } else {
-      for (i = 0; i < cxt->numChannels; ++i)
-        *output++ = subsample(cxt, cxt->buffers[i], cxt->outputOffset);
+    frames = plan_output(cxt, positions, numOutputFrames, numInputFrames, step, &needed);
 
-      cxt->outputOffset += (1.0f / ratio);
-      res.output_generated++;
-      numOutputFrames--;
+    for (j = 0; j < needed; j += run, input += run * cxt->numChannels) {
+      run = history_run(cxt, cxt->inputIndex + j, needed - j, &frame);
+      memcpy(cxt->history + frame * cxt->numChannels, input, run * cxt->numChannels * sizeof(float));
     }
+
+    mirror_history(cxt, cxt->inputIndex, needed);
+    cxt->inputIndex += needed;
+    res.input_used += needed;
+    numInputFrames -= needed;
+
+    for (j = 0; j < frames; ++j, output += cxt->numChannels)
+      for (i = 0; i < cxt->numChannels; i += RESAMPLE_CHANNEL_GROUP)
+        subsample(cxt, &positions[j], i, std::min(cxt->numChannels - i, RESAMPLE_CHANNEL_GROUP), output + i);
+
+    res.output_generated += frames;
+    numOutputFrames -= frames;
   }
 
   return res;
 }
 
+// These are the fixed-point versions of the interleaved resampler for contexts initialized with
+// the FIXED_POINT flag. The samples are 16-bit or 32-bit signed integers (full scale) and are
+// stored in the history with 24 bits of precision. The outputs are rounded and saturated to the
+// sample size, and the number of saturated samples is returned in the "clipped" field. They are
+// otherwise identical to the floating-point version (see above).
+
+ResampleResult resampleProcessInterleavedS16(Resample *cxt, const int16_t *input, int numInputFrames,
+                                             int16_t *output, int numOutputFrames, float ratio) {
+  return process_fixed(cxt, input, NULL, numInputFrames, output, NULL, numOutputFrames, ratio);
+}
+
+ResampleResult resampleProcessInterleavedS32(Resample *cxt, const int32_t *input, int numInputFrames,
+                                             int32_t *output, int numOutputFrames, float ratio) {
+  return process_fixed(cxt, NULL, input, numInputFrames, NULL, output, numOutputFrames, ratio);
+}
+
 // These two functions are not required for any application, but might be useful. Essentially
 // they allow a "dry run" of the resampler to determine beforehand how many input samples
 // would be consumed to generate a given output, or how many samples would be generated with
@@ -253,56 +714,53 @@ ResampleResult resampleProcessInterleaved(Resample *cxt, const float *input, int
 // an extra sample might be generated). Therefore it is important to restrict the output with
 // numOutputFrames if an exact output count is desired (don't just assume the input count can
 // exactly determine the output count).
+//
+// Both counts are computed in closed form from the current position rather than by stepping through
+// the resampler, so they cost the same for any number of frames. They are exact: in rational mode the
+// position is an integer index and phase, and otherwise the output offset is kept in double precision
+// where adding the single precision step (1.0f / ratio) never rounds, so the position of the k-th
+// output sample is exactly the current offset plus k steps.
 
 unsigned int resampleGetRequiredSamples(Resample *cxt, int numOutputFrames, float ratio) {
-  int half_taps = cxt->numTaps / 2;
-  int input_index = cxt->inputIndex;
-  float offset = cxt->outputOffset;
-  ResampleResult res = {0, 0};
+  int lookahead = cxt->lookahead;
 
-  while (numOutputFrames > 0) {
-    if (offset >= input_index - half_taps) {
-      if (input_index == cxt->numSamples) {
-        offset -= cxt->numSamples - cxt->numTaps;
-        input_index -= cxt->numSamples - cxt->numTaps;
-      }
+  if (numOutputFrames <= 0)
+    return 0;
 
-      input_index++;
-      res.input_used++;
-    } else {
-      offset += (1.0f / ratio);
-      numOutputFrames--;
-    }
+  if (cxt->upFactor) {
+    // index of the input sample at (or just before) the last output sample
+    int64_t last_index =
+        cxt->outputIndex + (cxt->outputPhase + (int64_t) (numOutputFrames - 1) * cxt->downFactor) / cxt->upFactor;
+
+    return (unsigned int) std::max<int64_t>(last_index + lookahead + 1 - cxt->inputIndex, 0);
   }
 
-  return res.input_used;
+  // output sample k can be generated once the input count exceeds position + k * step
+  double position = cxt->outputOffset - cxt->inputIndex + lookahead;
+  double last = position + (double) (numOutputFrames - 1) * (1.0f / ratio);
+
+  return last < 0.0 ? 0 : (unsigned int) floor(last) + 1;
 }
 
 unsigned int resampleGetExpectedOutput(Resample *cxt, int numInputFrames, float ratio) {
-  int half_taps = cxt->numTaps / 2;
-  int input_index = cxt->inputIndex;
-  float offset = cxt->outputOffset;
-  ResampleResult res = {0, 0};
-
-  while (1) {
-    if (offset >= input_index - half_taps) {
-      if (numInputFrames > 0) {
-        if (input_index == cxt->numSamples) {
-          offset -= cxt->numSamples - cxt->numTaps;
-          input_index -= cxt->numSamples - cxt->numTaps;
-        }
+  int lookahead = cxt->lookahead;
 
-        input_index++;
-        numInputFrames--;
-      } else
-        break;
-    } else {
-      offset += (1.0f / ratio);
-      res.output_generated++;
-    }
+  if (cxt->upFactor) {
+    // last input sample index that an output sample can be generated at once the input is consumed
+    int64_t last_index = (int64_t) cxt->inputIndex + std::max(numInputFrames, 0) - lookahead - 1;
+
+    if (last_index < cxt->outputIndex)
+      return 0;
+
+    int64_t phases = (last_index - cxt->outputIndex + 1) * cxt->upFactor - cxt->outputPhase;
+    return (unsigned int) ((phases + cxt->downFactor - 1) / cxt->downFactor);
   }
 
-  return res.output_generated;
+  // count of the k >= 0 for which position + k * step < numInputFrames
+  double position = cxt->outputOffset - cxt->inputIndex + lookahead;
+  double span = std::max(numInputFrames, 0) - position;
+
+  return span <= 0.0 ? 0 : (unsigned int) ceil(span / (1.0f / ratio));
 }
 
 // Advance the resampler output without generating any output, with the units referenced
@@ -313,7 +771,18 @@ unsigned int resampleGetExpectedOutput(Resample *cxt, int numInputFrames, float
 void resampleAdvancePosition(Resample *cxt, float delta) {
   if (delta < 0.0f)
     fprintf(stderr, "resampleAdvancePosition() can only advance forward!\n");
-  else
+  else if (cxt->upFactor) {
+    // in rational mode the fractional part is rounded to the nearest phase
+    int whole = (int) floor(delta);
+
+    cxt->outputIndex += whole;
+    cxt->outputPhase += (int) floor((delta - whole) * cxt->upFactor + 0.5f);
+
+    while (cxt->outputPhase >= cxt->upFactor) {
+      cxt->outputPhase -= cxt->upFactor;
+      cxt->outputIndex++;
+    }
+  } else
     cxt->outputOffset += delta;
 }
 
@@ -345,37 +814,230 @@ void resampleAdvancePosition(Resample *cxt, float delta) {
 //         break;
 // }
 
-float resampleGetPosition(Resample *cxt) { return cxt->outputOffset + (cxt->numTaps / 2.0f) - cxt->inputIndex; }
+float resampleGetPosition(Resample *cxt) {
+  if (cxt->upFactor)
+    return cxt->outputIndex + (float) cxt->outputPhase / cxt->upFactor + cxt->lookahead - cxt->inputIndex;
+
+  return cxt->outputOffset + cxt->lookahead - cxt->inputIndex;
+}
+
+// Return the group delay of the sinc filters at DC, in input samples. This is the signal delay
+// added by a freshly initialized (or reset) context, i.e. the amount resampleAdvancePosition()
+// must skip to align the output with the input. It is the lookahead (half the taps, or a quarter
+// with LOW_LATENCY) plus a small correction measured from the generated filters, which is only
+// significant for the asymmetrical LOW_LATENCY window. Any position already skipped is not
+// included, and the delay of higher frequencies differs with LOW_LATENCY (the filters are not
+// linear phase).
+
+float resampleGetLatency(Resample *cxt) { return cxt->lookahead + cxt->filterBank->delaySkew; }
 
 // Free all resources associated with the resampler context, including the context pointer
 // itself. Do not use the context after this call.
 
 void resampleFree(Resample *cxt) {
-  int i;
+  if (cxt->filterBank)
+    release_filter_bank(cxt->filterBank);
+
+  // NULL if the caller provided the memory (the context itself is in it, so this must be last)
+  internal::free_psram_fallback(cxt->memory);
+}
+
+// Convolve one filter with a group of up to RESAMPLE_CHANNEL_GROUP channels of the interleaved history, where
+// "stride" is the number of channels in each history frame. Tap i is filter[i * TapStep], so a stored filter is
+// applied backwards (as its mirror image) by pointing at its last tap with a TapStep of -1. Each filter tap is loaded
+// once and applied to every channel of the group. A single channel uses the Espressif assembly optimized dot product
+// (for filters applied forwards), stereo and four channel groups use dedicated kernels (SIMD across the channels on
+// hosts with SSE or NEON), and anything else falls back to a generic loop.
+
+template<int TapStep>
+static void apply_filter_generic(const float *filter, const float *source, int num_taps, int stride, int channels,
+                                 float *sums) {
+  float acc[RESAMPLE_CHANNEL_GROUP] = {0.0f};
+  int i, j;
+
+  for (i = 0; i < num_taps; ++i, filter += TapStep, source += stride)
+    for (j = 0; j < channels; ++j)
+      acc[j] += *filter * source[j];
+
+  for (j = 0; j < channels; ++j)
+    sums[j] = acc[j];
+}
+
+#if defined(RESAMPLE_SSE)
+// Load taps i through i + 3 of a filter applied with the given TapStep
+template<int TapStep> static inline __m128 load_taps(const float *filter, int i) {
+  if (TapStep > 0)
+    return _mm_loadu_ps(filter + i);
+
+  __m128 taps = _mm_loadu_ps(filter - i - 3);
+  return _mm_shuffle_ps(taps, taps, _MM_SHUFFLE(0, 1, 2, 3));
+}
+#elif defined(RESAMPLE_NEON)
+template<int TapStep> static inline float32x4_t load_taps(const float *filter, int i) {
+  if (TapStep > 0)
+    return vld1q_f32(filter + i);
+
+  float32x4_t taps = vrev64q_f32(vld1q_f32(filter - i - 3));
+  return vcombine_f32(vget_high_f32(taps), vget_low_f32(taps));
+}
+#endif
+
+// A single channel filter applied backwards (the dot product only reads forwards)
+
+template<int TapStep>
+static void apply_filter_mono(const float *filter, const float *source, int num_taps, float *sum) {
+#if defined(RESAMPLE_SSE)
+  __m128 acc = _mm_setzero_ps();
+
+  for (int i = 0; i < num_taps; i += 4)
+    acc = _mm_add_ps(acc, _mm_mul_ps(load_taps<TapStep>(filter, i), _mm_loadu_ps(source + i)));
+
+  acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+  *sum = _mm_cvtss_f32(_mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1)));
+#elif defined(RESAMPLE_NEON)
+  float32x4_t acc = vdupq_n_f32(0.0f);
+
+  for (int i = 0; i < num_taps; i += 4)
+    acc = vmlaq_f32(acc, load_taps<TapStep>(filter, i), vld1q_f32(source + i));
+
+  float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  *sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#else
+  float acc1 = 0.0f, acc2 = 0.0f;
+
+  for (int i = 0; i < num_taps; i += 2, filter += 2 * TapStep) {
+    acc1 += filter[0] * source[i];
+    acc2 += filter[TapStep] * source[i + 1];
+  }
+
+  *sum = acc1 + acc2;
+#endif
+}
+
+template<int TapStep>
+static void apply_filter_stereo(const float *filter, const float *source, int num_taps, int stride, float *sums) {
+#if defined(RESAMPLE_SSE)
+  if (stride == 2) {
+    __m128 acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps();
+
+    for (int i = 0; i < num_taps; i += 4, source += 8) {
+      __m128 taps, first, second;  // taps i and i + 1 duplicated for both channels, then taps i + 2 and i + 3
+
+      if (TapStep > 0) {
+        taps = _mm_loadu_ps(filter + i);
+        first = _mm_unpacklo_ps(taps, taps);
+        second = _mm_unpackhi_ps(taps, taps);
+      } else {
+        taps = _mm_loadu_ps(filter - i - 3);
+        first = _mm_shuffle_ps(taps, taps, _MM_SHUFFLE(2, 2, 3, 3));
+        second = _mm_shuffle_ps(taps, taps, _MM_SHUFFLE(0, 0, 1, 1));
+      }
+
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(first, _mm_loadu_ps(source)));
+      acc2 = _mm_add_ps(acc2, _mm_mul_ps(second, _mm_loadu_ps(source + 4)));
+    }
+
+    acc1 = _mm_add_ps(acc1, acc2);
+    acc1 = _mm_add_ps(acc1, _mm_movehl_ps(acc1, acc1));
+    sums[0] = _mm_cvtss_f32(acc1);
+    sums[1] = _mm_cvtss_f32(_mm_shuffle_ps(acc1, acc1, 1));
+    return;
+  }
+#elif defined(RESAMPLE_NEON)
+  if (stride == 2) {
+    float32x4_t acc_left = vdupq_n_f32(0.0f), acc_right = vdupq_n_f32(0.0f);
+
+    for (int i = 0; i < num_taps; i += 4, source += 8) {
+      float32x4_t taps = load_taps<TapStep>(filter, i);
+      float32x4x2_t frames = vld2q_f32(source);
+      acc_left = vmlaq_f32(acc_left, taps, frames.val[0]);
+      acc_right = vmlaq_f32(acc_right, taps, frames.val[1]);
+    }
 
-  for (i = 0; i <= cxt->numFilters; ++i)
-    internal::free_psram_fallback(cxt->filters[i]);
+    float32x2_t sum = vpadd_f32(vpadd_f32(vget_low_f32(acc_left), vget_high_f32(acc_left)),
+                                vpadd_f32(vget_low_f32(acc_right), vget_high_f32(acc_right)));
+    sums[0] = vget_lane_f32(sum, 0);
+    sums[1] = vget_lane_f32(sum, 1);
+    return;
+  }
+#endif
+  // two accumulators per channel (even and odd taps) to keep the FPU pipeline busy
+  float left1 = 0.0f, right1 = 0.0f, left2 = 0.0f, right2 = 0.0f;
+
+  for (int i = 0; i < num_taps; i += 2, filter += 2 * TapStep, source += 2 * stride) {
+    left1 += filter[0] * source[0];
+    right1 += filter[0] * source[1];
+    left2 += filter[TapStep] * source[stride];
+    right2 += filter[TapStep] * source[stride + 1];
+  }
 
-  free(cxt->filters);
+  sums[0] = left1 + left2;
+  sums[1] = right1 + right2;
+}
 
-  for (i = 0; i < cxt->numChannels; ++i)
-    internal::free_psram_fallback(cxt->buffers[i]);
+template<int TapStep>
+static void apply_filter_quad(const float *filter, const float *source, int num_taps, int stride, float *sums) {
+#if defined(RESAMPLE_SSE)
+  __m128 acc1 = _mm_setzero_ps(), acc2 = _mm_setzero_ps();
 
-  free(cxt->buffers);
-  free(cxt);
+  for (int i = 0; i < num_taps; i += 2, filter += 2 * TapStep, source += 2 * stride) {
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_set1_ps(filter[0]), _mm_loadu_ps(source)));
+    acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_set1_ps(filter[TapStep]), _mm_loadu_ps(source + stride)));
+  }
+
+  _mm_storeu_ps(sums, _mm_add_ps(acc1, acc2));
+#elif defined(RESAMPLE_NEON)
+  float32x4_t acc1 = vdupq_n_f32(0.0f), acc2 = vdupq_n_f32(0.0f);
+
+  for (int i = 0; i < num_taps; i += 2, filter += 2 * TapStep, source += 2 * stride) {
+    acc1 = vmlaq_n_f32(acc1, vld1q_f32(source), filter[0]);
+    acc2 = vmlaq_n_f32(acc2, vld1q_f32(source + stride), filter[TapStep]);
+  }
+
+  vst1q_f32(sums, vaddq_f32(acc1, acc2));
+#else
+  apply_filter_generic<TapStep>(filter, source, num_taps, stride, 4, sums);
+#endif
 }
 
-// Uses Espressif assembly optimize functions for the convolution operation
-static float apply_filter(float *A, float *B, int num_taps) {
-  float sum;
-  dsps_dotprod_f32(A, B, &sum, num_taps);
-  return sum;
+template<int TapStep>
+static void apply_filter(const float *filter, const float *source, int num_taps, int stride, int channels,
+                         float *sums) {
+  if (channels == 1 && stride == 1 && TapStep == 1)
+    dsps_dotprod_f32(filter, source, sums, num_taps);
+  else if (channels == 1 && stride == 1)
+    apply_filter_mono<TapStep>(filter, source, num_taps, sums);
+  else if (channels == 2)
+    apply_filter_stereo<TapStep>(filter, source, num_taps, stride, sums);
+  else if (channels == 4)
+    apply_filter_quad<TapStep>(filter, source, num_taps, stride, sums);
+  else
+    apply_filter_generic<TapStep>(filter, source, num_taps, stride, channels, sums);
+}
+
+// Apply filter "index" of the context's bank, reading the stored filter it mirrors backwards if it isn't stored itself
+
+static void apply_bank_filter(Resample *cxt, int index, const float *source, int channels, float *sums) {
+  if (index < cxt->filterBank->stored)
+    apply_filter<1>(cxt->filters[index], source, cxt->numTaps, cxt->numChannels, channels, sums);
+  else
+    apply_filter<-1>(cxt->filters[cxt->numFilters - index] + cxt->numTaps - 1, source, cxt->numTaps,
+                     cxt->numChannels, channels, sums);
 }
 
 #ifndef M_PI
 #define M_PI 3.14159265358979324
 #endif
 
+// Rotate the phasor (cos x, sin x) to x - step, given the cosine and sine of step
+
+static inline void rotate_phasor(double *cos_x, double *sin_x, double cos_step, double sin_step) {
+  double c = *cos_x;
+
+  *cos_x = c * cos_step + *sin_x * sin_step;
+  *sin_x = *sin_x * cos_step - c * sin_step;
+}
+
 static void init_filter(Resample *cxt, float *filter, float fraction, float lowpass_ratio) {
   const float a0 = 0.35875f;
   const float a1 = 0.48829f;
@@ -384,28 +1046,56 @@ static void init_filter(Resample *cxt, float *filter, float fraction, float lowp
   float filter_sum = 0.0f;
   int i;
 
-  // "dist" is the absolute distance from the sinc maximum to the filter tap to be calculated, in radians
-  // "ratio" is that distance divided by half the tap count such that it reaches π at the window extremes
+  // "center" is the position of the sinc maximum, (lookahead - fraction) taps before the last tap
+  // "dist" is the signed distance from the sinc maximum to the filter tap to be calculated, in radians
+  // "ratio" is that distance divided by the span of the window on that side of the maximum such that it
+  // reaches π at the window extremes; the window is symmetrical (both spans half the tap count) except
+  // with LOW_LATENCY, where the span of the newer samples is only the lookahead
 
   // Note that with this scaling, the odd terms of the Blackman-Harris calculation appear to be negated
   // with respect to the reference formula version.
 
+  // Both angles decrease by a constant step from tap to tap, so instead of evaluating sin() and cos() for
+  // every tap, the sine of the sinc and the cosine of the window ratio are rotated phasors (in double
+  // precision, so the error doesn't build up across the taps), and the window's harmonics come from the
+  // Chebyshev identities cos(2x) = 2cos²(x) - 1 and cos(3x) = 4cos³(x) - 3cos(x). The window phasor is
+  // restarted once where the span changes.
+
+  double center = cxt->numTaps - 1 - cxt->lookahead + fraction;
+  double sinc_step = M_PI * lowpass_ratio, sinc_cos = cos(center * sinc_step), sinc_sin = sin(center * sinc_step);
+  double cos_sinc_step = cos(sinc_step), sin_sinc_step = sin(sinc_step);
+  int span = cxt->numTaps - cxt->lookahead;
+  double window_step = M_PI / span, window_cos = cos(center * window_step), window_sin = sin(center * window_step);
+  double cos_window_step = cos(window_step), sin_window_step = sin(window_step);
+
   for (i = 0; i < cxt->numTaps; ++i) {
-    float dist = fabs((cxt->numTaps / 2 - 1) + fraction - i) * M_PI;
-    float ratio = dist / (cxt->numTaps / 2);
+    double dist = (center - i) * M_PI;
     float value;
 
-    if (dist != 0.0f) {
-      value = sin(dist * lowpass_ratio) / (dist * lowpass_ratio);
+    if (i > center && span != cxt->lookahead) {
+      span = cxt->lookahead;
+      window_step = M_PI / span;
+      window_cos = cos(dist / span);
+      window_sin = sin(dist / span);
+      cos_window_step = cos(window_step);
+      sin_window_step = sin(window_step);
+    }
+
+    if (dist != 0.0) {
+      float c = (float) window_cos;
+
+      value = sinc_sin / (dist * lowpass_ratio);
 
       if (cxt->flags & BLACKMAN_HARRIS)
-        value *= a0 + a1 * cos(ratio) + a2 * cos(2 * ratio) + a3 * cos(3 * ratio);
+        value *= a0 + a1 * c + a2 * (2.0f * c * c - 1.0f) + a3 * c * (4.0f * c * c - 3.0f);
       else
-        value *= 0.5f * (1.0f + cos(ratio));  // Hann window
+        value *= 0.5f * (1.0f + c);  // Hann window
     } else
       value = 1.0f;
 
     filter_sum += cxt->tempFilter[i] = value;
+    rotate_phasor(&sinc_cos, &sinc_sin, cos_sinc_step, sin_sinc_step);
+    rotate_phasor(&window_cos, &window_sin, cos_window_step, sin_window_step);
   }
 
   // filter should have unity DC gain
@@ -418,43 +1108,353 @@ static void init_filter(Resample *cxt, float *filter, float fraction, float lowp
   }
 }
 
-static float subsample_no_interpolate(Resample *cxt, float *source, float offset) {
-  source += (int) floor(offset);
-  offset -= floor(offset);
+// Return how much later than the sinc maximum the DC group delay of a filter falls, in input samples.
+// The group delay of an FIR at DC is the centroid of its taps (which sum to unity), and the newest
+// sample is in the last tap, so this is the distance from the centroid back to the sinc maximum.
 
-  if (offset == 0.0f && !(cxt->flags & INCLUDE_LOWPASS))
-    return *source;
+static float filter_delay_skew(Resample *cxt, const float *filter, float fraction) {
+  double centroid = 0.0, sum = 0.0;
+  int i;
 
-  return apply_filter(cxt->filters[(int) floor(offset * cxt->numFilters + 0.5f)], source - cxt->numTaps / 2 + 1,
-                      cxt->numTaps);
+  for (i = 0; i < cxt->numTaps; ++i) {
+    centroid += (double) i * filter[i];
+    sum += filter[i];
+  }
+
+  return (float) (cxt->numTaps - 1 - cxt->lookahead + fraction - centroid / sum);
 }
 
-static float subsample_interpolate(Resample *cxt, float *source, float offset) {
-  float sum1, sum2;
+// Quantize a filter generated by init_filter() to Q30, feeding the rounding error forward (in the
+// same center-out order) so that the fixed-point filter still has exactly unity DC gain
+
+static void quantize_filter(Resample *cxt, const float *filter, int32_t *fixed_filter) {
+  double error = 0.0;
   int i;
 
-  source += (int) floor(offset);
-  offset -= floor(offset);
+  for (i = cxt->numTaps / 2; i < cxt->numTaps; i = cxt->numTaps - i - (i >= cxt->numTaps / 2)) {
+    double value = ldexp(filter[i], FIXED_FILTER_BITS);
 
-  if (offset == 0.0f && !(cxt->flags & INCLUDE_LOWPASS))
-    return *source;
+    fixed_filter[i] = (int32_t) floor(value - error + 0.5);
+    error += fixed_filter[i] - value;
+  }
+}
+
+// The history is a ring of numSamples frames indexed by the input position modulo its length. Once
+// both the input position and the first frame the next output sample reads have passed a whole ring,
+// the positions are moved back by its length to keep them small (no samples move, so the cost of a
+// call doesn't depend on where in the ring it falls). Returns false if the next output sample cannot
+// be generated because the input is exhausted.
+
+static bool prepare_history(Resample *cxt, int numInputFrames) {
+  if (cxt->inputIndex >= cxt->numSamples && window_start(cxt) >= cxt->numSamples) {
+    cxt->outputOffset -= cxt->numSamples;
+    cxt->outputIndex -= cxt->numSamples;
+    cxt->inputIndex -= cxt->numSamples;
+  }
+
+  if (output_ready(cxt, cxt->inputIndex))
+    return true;
+
+  return numInputFrames > 0;
+}
+
+// Returns the input position of the first filter tap of the next output sample
+
+static int window_start(Resample *cxt) {
+  int center = cxt->numTaps - 1 - cxt->lookahead;
 
-  i = (int) floor(offset *= cxt->numFilters);
-  sum1 = apply_filter(cxt->filters[i], source - cxt->numTaps / 2 + 1, cxt->numTaps);
+  if (cxt->upFactor)
+    return cxt->outputIndex - center;
+
+  return (int) floor(cxt->outputOffset) - center;
+}
 
-  if ((offset -= i) == 0.0f && !(cxt->flags & INCLUDE_LOWPASS))
-    return sum1;
+// Returns the ring frame of an input position. Positions are less than two ring lengths except after
+// advancing the position far ahead, so this is usually a single subtraction instead of a division.
 
-  sum2 = apply_filter(cxt->filters[i + 1], source - cxt->numTaps / 2 + 1, cxt->numTaps);
+static int history_frame(Resample *cxt, int index) {
+  while (index >= cxt->numSamples)
+    index -= cxt->numSamples;
 
-  return sum2 * offset + sum1 * (1.0f - offset);
+  return index;
 }
 
-static float subsample(Resample *cxt, float *source, float offset) {
-  if (cxt->flags & SUBSAMPLE_INTERPOLATE)
-    return subsample_interpolate(cxt, source, offset);
+// Returns how many of "count" frames starting at input position "index" can be written to the
+// history before the end of the ring, and sets "frame" to the ring frame of that position
+
+static int history_run(Resample *cxt, int index, int count, int *frame) {
+  *frame = history_frame(cxt, index);
+  return std::min(count, cxt->numSamples - *frame);
+}
+
+// Copy any of the "count" frames just written starting at input position "index" that landed in the
+// first numTaps - 1 frames of the ring to the mirror after its end, so that a filter window starting
+// anywhere in the ring is contiguous. Only numTaps - 1 frames are copied per trip around the ring.
+
+static void mirror_history(Resample *cxt, int index, int count) {
+  int mirror = cxt->numTaps - 1, done, run, frame;
+
+  for (done = 0; done < count; done += run) {
+    run = history_run(cxt, index + done, count - done, &frame);
+
+    // both history formats have 4-byte samples
+    if (frame < mirror)
+      memcpy(cxt->history + (cxt->numSamples + frame) * cxt->numChannels, cxt->history + frame * cxt->numChannels,
+             (std::min(frame + run, mirror) - frame) * cxt->numChannels * sizeof(float));
+  }
+}
+
+// Returns true if the next output sample can be generated with the history filled up to inputLimit
+
+static bool output_ready(Resample *cxt, int inputLimit) {
+  if (cxt->upFactor)
+    return cxt->outputIndex < inputLimit - cxt->lookahead;
+
+  return cxt->outputOffset < inputLimit - cxt->lookahead;
+}
+
+// Compute the filter positions for the next block of output samples (up to RESAMPLE_BLOCK_FRAMES),
+// limited to those that can be generated with the input available and without overwriting the
+// ring frames the first of them reads. The positions are planned as input positions and then
+// mapped to ring frames. The output offset is advanced past the planned samples, and "needed" is set to
+// the number of input samples that must be appended to the history before generating them. If no
+// output sample fits then all the input that fits is requested instead. Returns the number of
+// output samples planned.
+
+static int plan_output(Resample *cxt, ResamplePosition *positions, int numOutputFrames, int numInputFrames, float step,
+                       int *needed) {
+  int center = cxt->numTaps - 1 - cxt->lookahead;  // tap at the output position for a zero fraction
+  int input_limit = cxt->inputIndex + std::min(numInputFrames, window_start(cxt) + cxt->numSamples - cxt->inputIndex);
+  int max_frames = std::min(numOutputFrames, RESAMPLE_BLOCK_FRAMES);
+  int frames = 0, i;
+
+  if (cxt->upFactor)
+    while (frames < max_frames && output_ready(cxt, input_limit)) {
+      ResamplePosition *pos = &positions[frames++];
+
+      pos->index = cxt->outputIndex - center;
+      pos->filter = (cxt->outputPhase || (cxt->flags & INCLUDE_LOWPASS)) ? cxt->outputPhase : -1;
+      pos->fraction = 0.0f;
+
+      cxt->outputPhase += cxt->downFactor;
+
+      while (cxt->outputPhase >= cxt->upFactor) {
+        cxt->outputPhase -= cxt->upFactor;
+        cxt->outputIndex++;
+      }
+    }
+  else
+    while (frames < max_frames && output_ready(cxt, input_limit)) {
+      ResamplePosition *pos = &positions[frames++];
+      // The fraction stays in double, as in float it can round up to 1.0 just below the next input frame
+      double offset = cxt->outputOffset - floor(cxt->outputOffset);
+
+      pos->index = (int) floor(cxt->outputOffset) - center;
+
+      if (offset == 0.0 && !(cxt->flags & INCLUDE_LOWPASS)) {
+        pos->filter = -1;
+      } else if (cxt->flags & SUBSAMPLE_INTERPOLATE) {
+        // the last filter interpolated from is numFilters - 1, at up to a whole step toward filter numFilters
+        offset *= cxt->numFilters;
+        pos->filter = std::min((int) offset, cxt->numFilters - 1);
+        pos->fraction = (float) std::min(offset - pos->filter, 1.0);
+      } else {
+        pos->filter = std::min((int) floor(offset * cxt->numFilters + 0.5), cxt->numFilters);
+        pos->fraction = 0.0f;
+      }
+
+      cxt->outputOffset += step;
+    }
+
+  if (frames)
+    *needed = std::max(positions[frames - 1].index + cxt->numTaps - cxt->inputIndex, 0);
   else
-    return subsample_no_interpolate(cxt, source, offset);
+    *needed = input_limit - cxt->inputIndex;
+
+  for (i = 0; i < frames; ++i)
+    positions[i].index = history_frame(cxt, positions[i].index);
+
+  return frames;
+}
+
+// Generate one output frame for the group of channels starting at "channel" at a position computed by plan_output()
+
+static void subsample(Resample *cxt, const ResamplePosition *pos, int channel, int channels, float *output) {
+  const float *source = cxt->history + pos->index * cxt->numChannels + channel;
+  float sums[RESAMPLE_CHANNEL_GROUP];
+  int i;
+
+  if (pos->filter < 0) {
+    source += (cxt->numTaps - 1 - cxt->lookahead) * cxt->numChannels;
+
+    for (i = 0; i < channels; ++i)
+      output[i] = source[i];
+
+    return;
+  }
+
+  apply_bank_filter(cxt, pos->filter, source, channels, output);
+
+  if (!(cxt->flags & SUBSAMPLE_INTERPOLATE) || (pos->fraction == 0.0f && !(cxt->flags & INCLUDE_LOWPASS)))
+    return;
+
+  apply_bank_filter(cxt, pos->filter + 1, source, channels, sums);
+
+  for (i = 0; i < channels; ++i)
+    output[i] = sums[i] * pos->fraction + output[i] * (1.0f - pos->fraction);
+}
+
+// Fixed-point version of apply_filter() for a group of channels, producing Q53 sums (Q30 taps times Q23 samples). As
+// with the floating-point version each tap is loaded once, tap i is filter[i * TapStep], and stereo uses two
+// accumulators per channel.
+
+template<int TapStep>
+static void apply_filter_fixed(const int32_t *filter, const int32_t *source, int num_taps, int stride, int channels,
+                               int64_t *sums) {
+  int i, j;
+
+  if (channels == 2) {
+    int64_t left1 = 0, right1 = 0, left2 = 0, right2 = 0;
+
+    for (i = 0; i < num_taps; i += 2, filter += 2 * TapStep, source += 2 * stride) {
+      left1 += (int64_t) filter[0] * source[0];
+      right1 += (int64_t) filter[0] * source[1];
+      left2 += (int64_t) filter[TapStep] * source[stride];
+      right2 += (int64_t) filter[TapStep] * source[stride + 1];
+    }
+
+    sums[0] = left1 + left2;
+    sums[1] = right1 + right2;
+    return;
+  }
+
+  for (j = 0; j < channels; ++j)
+    sums[j] = 0;
+
+  for (i = 0; i < num_taps; ++i, filter += TapStep, source += stride)
+    for (j = 0; j < channels; ++j)
+      sums[j] += (int64_t) *filter * source[j];
+}
+
+// Fixed-point version of apply_bank_filter()
+
+static void apply_bank_filter_fixed(Resample *cxt, int index, const int32_t *source, int channels, int64_t *sums) {
+  if (index < cxt->filterBank->stored)
+    apply_filter_fixed<1>(cxt->fixedFilters[index], source, cxt->numTaps, cxt->numChannels, channels, sums);
+  else
+    apply_filter_fixed<-1>(cxt->fixedFilters[cxt->numFilters - index] + cxt->numTaps - 1, source, cxt->numTaps,
+                           cxt->numChannels, channels, sums);
+}
+
+// Generate one output frame for the group of channels starting at "channel" at a position computed by plan_output(),
+// as Q31 values (not yet saturated)
+
+static void subsample_fixed(Resample *cxt, const ResamplePosition *pos, int channel, int channels, int64_t *output) {
+  const int32_t *source = cxt->fixedHistory + pos->index * cxt->numChannels + channel;
+  const int shift = FIXED_FILTER_BITS + FIXED_HISTORY_BITS - 32;
+  int64_t sums[RESAMPLE_CHANNEL_GROUP];
+  int i;
+
+  if (pos->filter < 0) {
+    source += (cxt->numTaps - 1 - cxt->lookahead) * cxt->numChannels;
+
+    for (i = 0; i < channels; ++i)
+      output[i] = (int64_t) source[i] * (1 << (32 - FIXED_HISTORY_BITS));
+
+    return;
+  }
+
+  apply_bank_filter_fixed(cxt, pos->filter, source, channels, output);
+
+  for (i = 0; i < channels; ++i)
+    output[i] = (output[i] + ((int64_t) 1 << (shift - 1))) >> shift;
+
+  if (!(cxt->flags & SUBSAMPLE_INTERPOLATE) || (pos->fraction == 0.0f && !(cxt->flags & INCLUDE_LOWPASS)))
+    return;
+
+  apply_bank_filter_fixed(cxt, pos->filter + 1, source, channels, sums);
+
+  int32_t fraction = (int32_t) (pos->fraction * 32768.0f);
+
+  for (i = 0; i < channels; ++i) {
+    sums[i] = (sums[i] + ((int64_t) 1 << (shift - 1))) >> shift;
+    output[i] = (sums[i] * fraction + output[i] * (32768 - fraction) + 16384) >> 15;
+  }
+}
+
+// Shared implementation of the fixed-point process functions; exactly one of input16/input32 and one of
+// output16/output32 is used. Input samples are converted to the history format as they are appended.
+
+static ResampleResult process_fixed(Resample *cxt, const int16_t *input16, const int32_t *input32, int numInputFrames,
+                                    int16_t *output16, int32_t *output32, int numOutputFrames, float ratio) {
+  ResamplePosition positions[RESAMPLE_BLOCK_FRAMES];
+  float step = 1.0f / ratio;
+  ResampleResult res = {0, 0, 0};
+  int output_shift = output16 ? 16 : 0;
+  int64_t high_clip = output16 ? INT16_MAX : INT32_MAX, low_clip = -high_clip - 1;
+  int frames, needed, run, frame, i, j, k;
+
+  while (numOutputFrames > 0) {
+    if (!prepare_history(cxt, numInputFrames))
+      break;
+
+    frames = plan_output(cxt, positions, numOutputFrames, numInputFrames, step, &needed);
+
+    for (j = 0; j < needed; j += run) {
+      run = history_run(cxt, cxt->inputIndex + j, needed - j, &frame);
+
+      int32_t *dst = cxt->fixedHistory + frame * cxt->numChannels;
+      int samples = run * cxt->numChannels;
+
+      if (input16) {
+        for (i = 0; i < samples; ++i)
+          dst[i] = (int32_t) input16[i] * (1 << (FIXED_HISTORY_BITS - 16));
+
+        input16 += samples;
+      } else {
+        // round to the history precision
+        for (i = 0; i < samples; ++i)
+          dst[i] = (input32[i] >> (32 - FIXED_HISTORY_BITS)) + ((input32[i] >> (31 - FIXED_HISTORY_BITS)) & 1);
+
+        input32 += samples;
+      }
+    }
+
+    mirror_history(cxt, cxt->inputIndex, needed);
+    cxt->inputIndex += needed;
+    res.input_used += needed;
+    numInputFrames -= needed;
+
+    for (j = 0; j < frames; ++j)
+      for (i = 0; i < cxt->numChannels; i += RESAMPLE_CHANNEL_GROUP) {
+        int channels = std::min(cxt->numChannels - i, RESAMPLE_CHANNEL_GROUP);
+        int64_t sums[RESAMPLE_CHANNEL_GROUP];
+
+        subsample_fixed(cxt, &positions[j], i, channels, sums);
+
+        for (k = 0; k < channels; ++k) {
+          int64_t value = output_shift ? (sums[k] + ((int64_t) 1 << (output_shift - 1))) >> output_shift : sums[k];
+
+          if (value > high_clip) {
+            value = high_clip;
+            res.clipped++;
+          } else if (value < low_clip) {
+            value = low_clip;
+            res.clipped++;
+          }
+
+          if (output16)
+            *output16++ = (int16_t) value;
+          else
+            *output32++ = (int32_t) value;
+        }
+      }
+
+    res.output_generated += frames;
+    numOutputFrames -= frames;
+  }
+
+  return res;
 }
 
 }  // namespace art_resampler
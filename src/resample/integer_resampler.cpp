@@ -0,0 +1,601 @@
+#include "integer_resampler.h"
+#include "../memory_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace esp_audio_libs {
+namespace resampler {
+
+// Zero crossings on each side of the sinc for the first decimating (last interpolating) stage of a cascade. It only has
+// to keep aliases out of the band that survives the other stage, so its transition band is very wide. The images an
+// interpolating one leaves are not filtered again, so it gets one more.
+static const uint16_t RELAXED_HALF_WIDTH = 6;
+static const uint16_t RELAXED_INTERPOLATING_HALF_WIDTH = 7;
+
+// The final stage is sized to reject as much as the ART resampler with the same number of taps, instead of matching its
+// length. Both are resampler_benchmark's quality (the smaller of the stopband rejection and the worst THD+N, in dB).
+// The ART resampler's is the best for 8, 16, 32, and 64 taps over the filter counts and subsample interpolation, and
+// over the 2, 3, 4, and 6 ratios in both directions, with the pre/post filter. A final stage's depends only on its
+// half width (from MIN_FINAL_HALF_WIDTH up), whatever the factor and direction. Past the end of the table, the
+// measurements reach the floor of the benchmark's test tones.
+static const uint16_t ART_MEASURED_TAPS = 8;  // the first of the octaves in ART_QUALITY_DB
+static const float ART_QUALITY_DB[] = {35.8f, 58.9f, 76.2f, 96.6f};
+static const uint16_t MIN_FINAL_HALF_WIDTH = 4;
+static const float FINAL_QUALITY_DB[] = {10.3f, 13.0f, 16.0f, 19.1f, 22.4f, 26.0f, 29.9f, 34.3f, 39.0f,
+                                         44.3f, 50.3f, 57.2f, 65.2f, 74.8f, 86.8f, 102.0f, 110.2f};
+
+// Frames moved through the scratch buffer between two stages at once
+static const size_t SCRATCH_FRAMES = 64;
+
+// Most outputs a decimating stage (or inputs an interpolating stage) filters at once
+static const size_t BLOCK_FRAMES = 32;
+
+// Blackman-Harris window (4-term) at t in [0, 1] from its center to its end
+static double blackman_harris(double t) {
+  return 0.35875 + 0.48829 * cos(M_PI * t) + 0.14128 * cos(2.0 * M_PI * t) + 0.01168 * cos(3.0 * M_PI * t);
+}
+
+// Tap of a windowed-sinc Nyquist(factor) filter spanning half_width * factor taps on each side of its center, at a
+// distance d from the center. The sinc is zero at every nonzero multiple of factor.
+static double nyquist_tap(int d, uint8_t factor, uint16_t half_width) {
+  if (d == 0) {
+    return 1.0 / factor;
+  }
+
+  const double x = M_PI * d / factor;
+  return sin(x) / x / factor * blackman_harris(fabs((double) d) / (half_width * factor));
+}
+
+uint32_t IntegerResampler::get_factor(float source_sample_rate, float target_sample_rate) {
+  const float low = std::min(source_sample_rate, target_sample_rate);
+  const float high = std::max(source_sample_rate, target_sample_rate);
+
+  if ((low < 1.0f) || (fmodf(high, low) != 0.0f)) {
+    return 0;
+  }
+
+  const uint32_t factor = (uint32_t) (high / low);
+
+  if ((factor == 2) || (factor == 3) || (factor == 4) || (factor == 6)) {
+    return factor;
+  }
+
+  return 0;
+}
+
+// Half width of the final stage that rejects at least as much as the ART resampler with number_of_taps
+static uint16_t final_half_width(uint16_t number_of_taps) {
+  const int art_count = sizeof(ART_QUALITY_DB) / sizeof(ART_QUALITY_DB[0]);
+  const int final_count = sizeof(FINAL_QUALITY_DB) / sizeof(FINAL_QUALITY_DB[0]);
+
+  // The ART resampler's quality, interpolated by octaves between the measured tap counts and extrapolated past them
+  const float octaves = log2f(std::max<float>(number_of_taps, 1.0f) / ART_MEASURED_TAPS);
+  const int octave = std::min(std::max((int) floorf(octaves), 0), art_count - 2);
+  const float target =
+      ART_QUALITY_DB[octave] + (octaves - octave) * (ART_QUALITY_DB[octave + 1] - ART_QUALITY_DB[octave]);
+
+  int i = 0;
+  while ((i < final_count - 1) && (FINAL_QUALITY_DB[i] < target)) {
+    ++i;
+  }
+
+  return MIN_FINAL_HALF_WIDTH + i;
+}
+
+// Sets the factor and half width of each stage, in processing order, for a supported factor and returns the number of
+// stages. The final stage is the one at the lower rate: last when decimating, first when interpolating.
+static uint8_t plan_stages(uint32_t factor, bool interpolate, uint16_t number_of_taps, uint8_t *factors,
+                           uint16_t *half_widths) {
+  const uint16_t half_width = final_half_width(number_of_taps);
+  const uint8_t final_factor = (factor % 3 == 0) ? 3 : 2;
+
+  if (factor == final_factor) {
+    factors[0] = final_factor;
+    half_widths[0] = half_width;
+    return 1;
+  }
+
+  const int final_stage = interpolate ? 0 : 1;
+
+  factors[final_stage] = final_factor;
+  half_widths[final_stage] = half_width;
+  factors[1 - final_stage] = 2;
+  half_widths[1 - final_stage] = interpolate ? RELAXED_INTERPOLATING_HALF_WIDTH : RELAXED_HALF_WIDTH;
+  return 2;
+}
+
+// Mirrors the allocations of initialize_stage_()
+static size_t stage_memory_size(uint8_t factor, bool interpolate, uint16_t half_width, uint8_t channels) {
+  const size_t frame_bytes = channels * sizeof(float);
+
+  if (interpolate) {
+    return 2 * half_width * sizeof(float) + 2 * BLOCK_FRAMES * frame_bytes + factor * frame_bytes +
+           (2 * half_width + BLOCK_FRAMES) * frame_bytes;
+  }
+
+  const size_t span = half_width * factor;
+  return (span - half_width) * (sizeof(float) + 2 * sizeof(uint16_t)) +
+         (3 * span - 1 + BLOCK_FRAMES * factor) * frame_bytes + factor * (BLOCK_FRAMES + 2 * half_width) * frame_bytes;
+}
+
+size_t IntegerResampler::get_memory_size(float source_sample_rate, float target_sample_rate, uint8_t channels,
+                                         uint16_t number_of_taps) {
+  const uint32_t factor = get_factor(source_sample_rate, target_sample_rate);
+  const bool interpolate = target_sample_rate > source_sample_rate;
+  uint8_t factors[2];
+  uint16_t half_widths[2];
+
+  if (factor == 0) {
+    return 0;
+  }
+
+  const uint8_t stage_count = plan_stages(factor, interpolate, number_of_taps, factors, half_widths);
+  size_t size = (stage_count > 1) ? SCRATCH_FRAMES * channels * sizeof(float) : 0;
+
+  for (uint8_t i = 0; i < stage_count; ++i) {
+    size += stage_memory_size(factors[i], interpolate, half_widths[i], channels);
+  }
+
+  return size;
+}
+
+// A decimating stage multiplies each of its tap pairs and its center tap once per output. An interpolating stage
+// multiplies each tap pair of phase 1 once per input (half_width of them for a factor of 2, and both parts for a factor
+// of 3), which gives factor outputs. An earlier stage runs at a rate the later stage's factor higher (decimating) or
+// lower (interpolating).
+float IntegerResampler::get_multiplies_per_frame(float source_sample_rate, float target_sample_rate,
+                                                 uint16_t number_of_taps) {
+  const uint32_t factor = get_factor(source_sample_rate, target_sample_rate);
+  const bool interpolate = target_sample_rate > source_sample_rate;
+  uint8_t factors[2];
+  uint16_t half_widths[2];
+
+  if (factor == 0) {
+    return 0.0f;
+  }
+
+  float multiplies = 0.0f, outputs = 1.0f;  // outputs of the stage per final output frame
+
+  for (int i = plan_stages(factor, interpolate, number_of_taps, factors, half_widths) - 1; i >= 0; --i) {
+    if (interpolate) {
+      multiplies += outputs * (factors[i] - 1) * half_widths[i] / factors[i];
+      outputs /= factors[i];
+    } else {
+      multiplies += outputs * ((factors[i] - 1) * half_widths[i] + 1);
+      outputs *= factors[i];
+    }
+  }
+
+  return multiplies;
+}
+
+bool IntegerResampler::initialize(float source_sample_rate, float target_sample_rate, uint8_t channels,
+                                  uint16_t number_of_taps) {
+  this->release();
+
+  this->factor_ = get_factor(source_sample_rate, target_sample_rate);
+  this->interpolate_ = target_sample_rate > source_sample_rate;
+  this->channels_ = channels;
+
+  if ((this->factor_ == 0) || (channels == 0)) {
+    return false;
+  }
+
+  uint8_t factors[2];
+  uint16_t half_widths[2];
+
+  this->stage_count_ = plan_stages(this->factor_, this->interpolate_, number_of_taps, factors, half_widths);
+
+  for (uint8_t i = 0; i < this->stage_count_; ++i) {
+    if (!this->initialize_stage_(&this->stages_[i], factors[i], this->interpolate_, half_widths[i])) {
+      return false;
+    }
+  }
+
+  if (this->stage_count_ > 1) {
+    this->scratch_frames_ = SCRATCH_FRAMES;
+    this->scratch_ = (float *) internal::alloc_psram_fallback(SCRATCH_FRAMES * channels * sizeof(float));
+    if (this->scratch_ == nullptr) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void IntegerResampler::release() {
+  for (Stage &stage : this->stages_) {
+    internal::free_psram_fallback(stage.coefficients);
+    internal::free_psram_fallback(stage.offsets);
+    internal::free_psram_fallback(stage.phases);
+    internal::free_psram_fallback(stage.history);
+    internal::free_psram_fallback(stage.accumulator);
+    internal::free_psram_fallback(stage.pending);
+    stage = Stage();
+  }
+
+  internal::free_psram_fallback(this->scratch_);
+  this->scratch_ = nullptr;
+  this->scratch_frames_ = 0;
+  this->stage_count_ = 0;
+  this->factor_ = 0;
+}
+
+bool IntegerResampler::initialize_stage_(Stage *stage, uint8_t factor, bool interpolate, uint16_t half_width) {
+  const int span = half_width * factor;  // taps on each side of the center, counting the zero at the end
+
+  stage->factor = factor;
+  stage->interpolate = interpolate;
+  stage->half_width = half_width;
+
+  if (interpolate) {
+    // Phase p of the upsampled filter over the window of 2 * half_width inputs (oldest first) has the taps at
+    // distances p + factor * (half_width - 1 - i), scaled by factor for the gain lost to the inserted zeros
+    const int taps = 2 * half_width;
+    float *phase = (float *) internal::alloc_psram_fallback(taps * sizeof(float));
+
+    stage->window_frames = taps;
+    stage->history_frames = taps + BLOCK_FRAMES;
+    stage->coefficients = (float *) internal::alloc_psram_fallback(taps * sizeof(float));
+    stage->accumulator = (float *) internal::alloc_psram_fallback(2 * BLOCK_FRAMES * this->channels_ * sizeof(float));
+    stage->pending = (float *) internal::alloc_psram_fallback(factor * this->channels_ * sizeof(float));
+
+    if ((phase == nullptr) || (stage->coefficients == nullptr) || (stage->accumulator == nullptr) ||
+        (stage->pending == nullptr)) {
+      internal::free_psram_fallback(phase);
+      return false;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < taps; ++i) {
+      phase[i] = factor * nyquist_tap(1 + factor * (half_width - 1 - i), factor, half_width);
+      sum += phase[i];
+    }
+
+    // Each phase is normalized to unity DC gain; phase 1 of a half-band filter is symmetrical, so only the first half
+    // is kept, and otherwise the even and odd parts are kept so phase 2 (phase 1 reversed) shares the multiplies
+    for (int i = 0; i < half_width; ++i) {
+      const float newer = phase[taps - 1 - i] / sum;
+      const float older = phase[i] / sum;
+
+      if (factor == 2) {
+        stage->coefficients[i] = older;
+      } else {
+        stage->coefficients[i] = (older + newer) / 2.0f;
+        stage->coefficients[half_width + i] = (older - newer) / 2.0f;
+      }
+    }
+
+    internal::free_psram_fallback(phase);
+
+    stage->phase = 0;
+    stage->prime = half_width;
+  } else {
+    // Every tap at a multiple of the factor from the center is zero, so only the other pairs are stored
+    const size_t phase_frames = BLOCK_FRAMES + 2 * half_width;
+
+    stage->window_frames = 2 * span - 1;
+    stage->history_frames = stage->window_frames + span + BLOCK_FRAMES * factor;
+    stage->pairs = span - half_width;
+    stage->coefficients = (float *) internal::alloc_psram_fallback(stage->pairs * sizeof(float));
+    stage->offsets = (uint16_t *) internal::alloc_psram_fallback(2 * stage->pairs * sizeof(uint16_t));
+    stage->phases = (float *) internal::alloc_psram_fallback(factor * phase_frames * this->channels_ * sizeof(float));
+
+    if ((stage->coefficients == nullptr) || (stage->offsets == nullptr) || (stage->phases == nullptr)) {
+      return false;
+    }
+
+    // Outputs past the end of a short block are computed from whatever was left in the phases, so it starts as silence
+    memset(stage->phases, 0, factor * phase_frames * this->channels_ * sizeof(float));
+
+    // A tap at distance d after the center of output b is at phase d % factor, frame half_width + d / factor + b of
+    // the phases (see decimate_stage_()), and the one before it at the mirror image of that phase, a frame earlier
+    double sum = 0.0;
+    for (int d = 1, i = 0; d < span; ++d) {
+      if (d % factor) {
+        stage->offsets[i] = (factor - d % factor) * phase_frames + half_width - d / factor - 1;
+        stage->offsets[stage->pairs + i] = (d % factor) * phase_frames + half_width + d / factor;
+        stage->coefficients[i] = nyquist_tap(d, factor, half_width);
+        sum += 2.0 * stage->coefficients[i++];
+      }
+    }
+
+    // Unity DC gain, keeping the center tap at exactly 1 / factor
+    const double scale = (1.0 - 1.0 / factor) / sum;
+    for (int i = 0; i < stage->pairs; ++i) {
+      stage->coefficients[i] *= scale;
+    }
+
+    // the first output is due once its window is centered on the first input
+    stage->phase = factor - span;
+  }
+
+  // The history starts with silence up to the center (or newest interpolated) position of the first window, so the
+  // output is aligned with the input
+  stage->history = (float *) internal::alloc_psram_fallback(stage->history_frames * this->channels_ * sizeof(float));
+
+  if (stage->history == nullptr) {
+    return false;
+  }
+
+  stage->fill = interpolate ? half_width - 1 : span - 1;
+  memset(stage->history, 0, stage->fill * this->channels_ * sizeof(float));
+
+  return true;
+}
+
+size_t IntegerResampler::stage_required_input_(const Stage *stage, size_t output_frames) {
+  if (output_frames == 0) {
+    return 0;
+  }
+
+  if (stage->interpolate) {
+    // a new input is taken for each phase 0 output
+    const size_t phase = stage->phase;
+    const size_t inputs = (output_frames + phase + stage->factor - 1) / stage->factor - (phase > 0);
+
+    return inputs ? inputs + stage->prime : 0;
+  }
+
+  return (stage->factor - stage->phase) + (output_frames - 1) * stage->factor;
+}
+
+size_t IntegerResampler::required_input(size_t output_frames) const {
+  size_t frames = output_frames;
+
+  for (int i = this->stage_count_ - 1; i >= 0; --i) {
+    frames = stage_required_input_(&this->stages_[i], frames);
+  }
+
+  return frames;
+}
+
+void IntegerResampler::push_frames_(Stage *stage, const float *input, size_t frames) {
+  const size_t frame_bytes = this->channels_ * sizeof(float);
+
+  if (stage->fill + frames > stage->history_frames) {
+    const size_t keep = stage->window_frames - 1;
+    memmove(stage->history, stage->history + (stage->fill - keep) * this->channels_, keep * frame_bytes);
+    stage->fill = keep;
+  }
+
+  memcpy(stage->history + stage->fill * this->channels_, input, frames * frame_bytes);
+  stage->fill += frames;
+}
+
+void IntegerResampler::decimate_stage_(Stage *stage, const float *input, size_t input_frames, float *output,
+                                       size_t output_frames, size_t *frames_used, size_t *frames_generated) {
+  const int channels = this->channels_;
+  const size_t factor = stage->factor;
+  const size_t span = stage->half_width * factor;
+  const size_t phase_frames = BLOCK_FRAMES + 2 * stage->half_width;
+  const float gain = 1.0f / factor;
+  size_t used = 0, generated = 0;
+
+  while (generated < output_frames) {
+    const size_t available = input_frames - used;
+    const size_t first = factor - stage->phase;  // inputs up to the next output
+
+    if (available < first) {
+      this->push_frames_(stage, input + used * channels, available);
+      stage->phase += available;
+      used += available;
+      break;
+    }
+
+    // Take in the inputs for a block of outputs at once, whose windows are centered factor frames apart
+    const size_t block = std::min(std::min(output_frames - generated, BLOCK_FRAMES), 1 + (available - first) / factor);
+    const size_t frames = first + (block - 1) * factor;
+
+    this->push_frames_(stage, input + used * channels, frames);
+    stage->phase = 0;
+    used += frames;
+
+    // Each channel of the windows is split into factor phases, frame j of phase r being the input at j * factor + r
+    // from span frames before the first center. The centers are then frames half_width on of phase 0, and the taps at
+    // each distance from them are contiguous too, so each tap pair is applied to the whole block at once.
+    const size_t first_center = stage->fill - (block - 1) * factor - stage->window_frames / 2 - 1;
+    const size_t newest = (block - 1) * factor + 2 * span - 1;  // last input of the windows, from the start
+    float *out = output + generated * channels;
+
+    for (int c = 0; c < channels; ++c) {
+      float *phases = stage->phases + c * factor * phase_frames;
+      const float *start = stage->history + (first_center - span) * channels + c;
+
+      // the start itself is never read, and may come before the history
+      for (size_t r = 0; r < factor; ++r) {
+        for (size_t j = (r == 0), position = j * factor + r; position <= newest; ++j, position += factor) {
+          phases[r * phase_frames + j] = start[position * channels];
+        }
+      }
+
+      // A whole block every time, a count the compiler can vectorize; outputs past the end of a short one are dropped
+      float sums[BLOCK_FRAMES];
+      const float *center = phases + stage->half_width;
+
+      for (size_t b = 0; b < BLOCK_FRAMES; ++b) {
+        sums[b] = center[b] * gain;
+      }
+
+      for (int i = 0; i < stage->pairs; ++i) {
+        const float coefficient = stage->coefficients[i];
+        const float *older = phases + stage->offsets[i];
+        const float *newer = phases + stage->offsets[stage->pairs + i];
+
+        for (size_t b = 0; b < BLOCK_FRAMES; ++b) {
+          sums[b] += coefficient * (older[b] + newer[b]);
+        }
+      }
+
+      for (size_t b = 0; b < block; ++b) {
+        out[b * channels + c] = sums[b];
+      }
+    }
+
+    generated += block;
+  }
+
+  *frames_used = used;
+  *frames_generated = generated;
+}
+
+void IntegerResampler::interpolate_groups_(Stage *stage, size_t groups, float *output) {
+  const int channels = this->channels_;
+  const int taps = 2 * stage->half_width;
+  const size_t samples = groups * channels;
+  const float *window = stage->history + (stage->fill - groups - taps + 1) * channels;  // the first group's
+  float *even = stage->accumulator;
+  float *odd = stage->accumulator + BLOCK_FRAMES * channels;
+
+  // Every group's window is one frame after the previous one's, so each tap pair is applied to all of them at once
+  memset(even, 0, samples * sizeof(float));
+  memset(odd, 0, samples * sizeof(float));
+
+  for (int i = 0; i < stage->half_width; ++i) {
+    const float *older = window + i * channels;
+    const float *newer = window + (taps - 1 - i) * channels;
+    const float even_coefficient = stage->coefficients[i];
+
+    for (size_t j = 0; j < samples; ++j) {
+      even[j] += even_coefficient * (older[j] + newer[j]);
+    }
+
+    if (stage->factor == 3) {
+      const float odd_coefficient = stage->coefficients[stage->half_width + i];
+
+      for (size_t j = 0; j < samples; ++j) {
+        odd[j] += odd_coefficient * (older[j] - newer[j]);
+      }
+    }
+  }
+
+  // phase 0 is the input frame at the center of the window
+  const float *center = window + (stage->half_width - 1) * channels;
+
+  for (size_t g = 0; g < groups; ++g) {
+    float *frame = output + g * stage->factor * channels;
+
+    for (int c = 0; c < channels; ++c) {
+      const size_t j = g * channels + c;
+
+      frame[c] = center[j];
+      frame[channels + c] = even[j] + odd[j];
+      if (stage->factor == 3) {
+        frame[2 * channels + c] = even[j] - odd[j];
+      }
+    }
+  }
+}
+
+void IntegerResampler::interpolate_stage_(Stage *stage, const float *input, size_t input_frames, float *output,
+                                          size_t output_frames, size_t *frames_used, size_t *frames_generated) {
+  const int channels = this->channels_;
+  const size_t factor = stage->factor;
+  size_t used = 0, generated = 0;
+
+  // outputs left over from a group that didn't fit last time
+  while ((stage->phase != 0) && (generated < output_frames)) {
+    memcpy(output + generated * channels, stage->pending + stage->phase * channels, channels * sizeof(float));
+    stage->phase = (stage->phase + 1) % factor;
+    ++generated;
+  }
+
+  while ((generated < output_frames) && (used < input_frames)) {
+    if (stage->prime > 0) {
+      const size_t frames = std::min(std::min(stage->prime, BLOCK_FRAMES), input_frames - used);
+
+      this->push_frames_(stage, input + used * channels, frames);
+      stage->prime -= frames;
+      used += frames;
+      continue;
+    }
+
+    const size_t groups = std::min(std::min(input_frames - used, (output_frames - generated) / factor), BLOCK_FRAMES);
+
+    if (groups == 0) {
+      // only part of the next group fits, so the rest of it is kept for the next call
+      this->push_frames_(stage, input + used * channels, 1);
+      this->interpolate_groups_(stage, 1, stage->pending);
+      ++used;
+
+      stage->phase = output_frames - generated;
+      memcpy(output + generated * channels, stage->pending, stage->phase * channels * sizeof(float));
+      generated = output_frames;
+      break;
+    }
+
+    this->push_frames_(stage, input + used * channels, groups);
+    this->interpolate_groups_(stage, groups, output + generated * channels);
+    used += groups;
+    generated += groups * factor;
+  }
+
+  *frames_used = used;
+  *frames_generated = generated;
+}
+
+void IntegerResampler::run_stage_(Stage *stage, const float *input, size_t input_frames, float *output,
+                                  size_t output_frames, size_t *frames_used, size_t *frames_generated) {
+  if (stage->interpolate) {
+    this->interpolate_stage_(stage, input, input_frames, output, output_frames, frames_used, frames_generated);
+  } else {
+    this->decimate_stage_(stage, input, input_frames, output, output_frames, frames_used, frames_generated);
+  }
+}
+
+void IntegerResampler::process(const float *input, size_t input_frames, float *output, size_t output_frames,
+                               size_t *frames_used, size_t *frames_generated) {
+  if (this->stage_count_ == 1) {
+    this->run_stage_(&this->stages_[0], input, input_frames, output, output_frames, frames_used, frames_generated);
+    return;
+  }
+
+  size_t used = 0, generated = 0;
+
+  // The first stage only produces what the second needs for the output space left, so the scratch buffer is always
+  // drained by the second stage
+  while (true) {
+    const size_t needed = stage_required_input_(&this->stages_[1], output_frames - generated);
+    size_t first_used, first_generated, second_used, second_generated;
+
+    this->run_stage_(&this->stages_[0], input + used * this->channels_, input_frames - used, this->scratch_,
+                     std::min(needed, this->scratch_frames_), &first_used, &first_generated);
+    this->run_stage_(&this->stages_[1], this->scratch_, first_generated, output + generated * this->channels_,
+                     output_frames - generated, &second_used, &second_generated);
+
+    if ((first_used == 0) && (second_generated == 0)) {
+      break;
+    }
+
+    used += first_used;
+    generated += second_generated;
+  }
+
+  *frames_used = used;
+  *frames_generated = generated;
+}
+
+float IntegerResampler::latency_frames() const {
+  float latency = 0.0f;
+
+  // Each stage's lookahead in its own output frames, scaled to the final output rate by the stages after it. A
+  // decimator's output waits for the inputs up to the end of its window, and an interpolator's for the newest input
+  // of its window.
+  for (int i = 0; i < this->stage_count_; ++i) {
+    const Stage &stage = this->stages_[i];
+    const float factor = stage.factor;
+
+    if (stage.interpolate) {
+      latency = latency * factor + stage.half_width * factor;
+    } else {
+      latency = latency / factor + (stage.half_width * factor - 1.0f) / factor;
+    }
+  }
+
+  return latency;
+}
+
+}  // namespace resampler
+}  // namespace esp_audio_libs
@@ -0,0 +1,135 @@
+#include "interpolating_resampler.h"
+#include "../memory_utils.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace esp_audio_libs {
+namespace resampler {
+
+// Fraction bits of the fixed-point position. Stepping it is a 64-bit integer add, which is much cheaper than double
+// precision arithmetic on chips with a single precision FPU, and rounding the step to 2^-32 frames doesn't drift
+// measurably.
+static const int POSITION_BITS = 32;
+static const float FRACTION_SCALE = 1.0f / 4294967296.0f;  // 2^-POSITION_BITS
+
+// Input frames per output frame at the given ratio, in the fixed-point position format
+static uint64_t position_step(float ratio) { return (uint64_t) (ldexp(1.0, POSITION_BITS) / ratio + 0.5); }
+
+bool InterpolatingResampler::initialize(uint8_t channels, InterpolationMode mode) {
+  this->release();
+
+  if ((mode != INTERPOLATION_LINEAR) && (mode != INTERPOLATION_CUBIC)) {
+    return false;
+  }
+
+  this->taps_ = (mode == INTERPOLATION_CUBIC) ? 4 : 2;
+  this->channels_ = channels;
+
+  // The history starts out silent, and the first output sample falls on the first input frame
+  const size_t window_samples = (size_t) this->taps_ * channels;
+  this->history_ = (float *) internal::alloc_psram_fallback(2 * window_samples * sizeof(float));
+
+  if (this->history_ == nullptr) {
+    return false;
+  }
+
+  memset(this->history_, 0, 2 * window_samples * sizeof(float));
+  this->window_frames_ = this->history_ + window_samples;
+  this->position_ = (uint64_t) (this->taps_ / 2 + 1) << POSITION_BITS;
+
+  return true;
+}
+
+void InterpolatingResampler::release() {
+  internal::free_psram_fallback(this->history_);
+  this->history_ = nullptr;
+  this->window_frames_ = nullptr;
+  this->taps_ = 0;
+}
+
+// The last of the output frames needs the virtual frames up to floor(position) + taps_ - 1, i.e. the input frames up to
+// floor(position) - 1
+size_t InterpolatingResampler::required_input(size_t output_frames, float ratio) const {
+  if (output_frames == 0) {
+    return 0;
+  }
+
+  return (size_t) ((this->position_ + (output_frames - 1) * position_step(ratio)) >> POSITION_BITS);
+}
+
+const float *InterpolatingResampler::window_(const float *input, size_t index) {
+  if (index >= this->taps_) {
+    return input + (index - this->taps_) * this->channels_;
+  }
+
+  for (size_t i = 0; i < this->taps_; ++i, ++index) {
+    const float *frame = (index < this->taps_) ? this->history_ + index * this->channels_
+                                               : input + (index - this->taps_) * this->channels_;
+    memcpy(this->window_frames_ + i * this->channels_, frame, this->channels_ * sizeof(float));
+  }
+
+  return this->window_frames_;
+}
+
+void InterpolatingResampler::process(const float *input, size_t input_frames, float *output, size_t output_frames,
+                                     float ratio, size_t *frames_used, size_t *frames_generated) {
+  const uint64_t step = position_step(ratio);
+  const size_t channels = this->channels_;
+  const size_t taps = this->taps_;
+  uint64_t position = this->position_;
+  size_t generated = 0, index = 0;
+
+  for (; generated < output_frames; ++generated, position += step, output += channels) {
+    // stop at the first window that runs past the input (virtual frames from input_frames + taps on)
+    if ((size_t) (position >> POSITION_BITS) > input_frames) {
+      break;
+    }
+
+    index = (size_t) (position >> POSITION_BITS);
+    const float t = (float) (uint32_t) position * FRACTION_SCALE;
+    const float *x = this->window_(input, index);
+
+    if (taps == 2) {
+      for (size_t c = 0; c < channels; ++c) {
+        output[c] = x[c] + t * (x[channels + c] - x[c]);
+      }
+    } else {
+      for (size_t c = 0; c < channels; ++c) {
+        const float xm1 = x[c], x0 = x[channels + c], x1 = x[2 * channels + c], x2 = x[3 * channels + c];
+        const float c1 = 0.5f * (x1 - xm1);
+        const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+        const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+        output[c] = ((c3 * t + c2) * t + c1) * t + x0;
+      }
+    }
+  }
+
+  // Consume the input up to the frames the last output needed if the output space filled up, or all of it otherwise
+  size_t used = input_frames;
+
+  if (generated == output_frames) {
+    used = (generated > 0) ? index : 0;
+  }
+
+  // Keep the last taps_ frames consumed, moving the virtual frames used through taps_ - 1 to the start. Frames from
+  // the history only move toward the start, so they're copied before they're overwritten.
+  for (size_t i = 0; i < this->taps_; ++i) {
+    const size_t frame = used + i;
+
+    if (frame < this->taps_) {
+      memmove(this->history_ + i * channels, this->history_ + frame * channels, channels * sizeof(float));
+    } else {
+      memcpy(this->history_ + i * channels, input + (frame - this->taps_) * channels, channels * sizeof(float));
+    }
+  }
+
+  this->position_ = position - ((uint64_t) used << POSITION_BITS);
+
+  *frames_used = used;
+  *frames_generated = generated;
+}
+
+}  // namespace resampler
+}  // namespace esp_audio_libs
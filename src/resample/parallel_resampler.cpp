@@ -0,0 +1,423 @@
+#include "parallel_resampler.h"
+#include "quantization_utils.h"
+#include "../memory_utils.h"
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace esp_audio_libs {
+namespace resampler {
+
+// Fewest output frames worth giving a thread of their own. Each chunk's resampler is initialized and its history
+// filled separately, which costs about as much as resampling a few thousand frames.
+static const size_t MIN_CHUNK_FRAMES = 16384;
+
+// Most frames passed to a conversion, biquad, or resampler call at once, which all count samples or frames in 32 bits
+static const size_t CALL_FRAMES = 65536;
+
+// Splits frames into at most threads parts of at least MIN_CHUNK_FRAMES, returning how many there are
+static size_t count_parts(size_t frames, size_t threads) {
+  return std::max<size_t>(std::min(threads, frames / MIN_CHUNK_FRAMES), 1);
+}
+
+// First frame of a part of frames split into parts as evenly as possible
+static size_t part_start(size_t frames, size_t parts, size_t part) { return frames * part / parts; }
+
+// Runs work(part) for every part, each on its own thread except part 0, which runs on the calling thread
+template<typename Work> static void run_parts(size_t parts, const Work &work) {
+  std::vector<std::thread> threads;
+
+  for (size_t part = 1; part < parts; ++part) {
+    threads.emplace_back(std::cref(work), part);
+  }
+
+  work(0);
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+// A Resampler whose stages can be run one at a time over a whole recording, with the resampling engine split into
+// chunks that each run on their own ChunkResampler
+class ChunkResampler : public Resampler {
+ public:
+  ChunkResampler(size_t input_buffer_samples, size_t output_buffer_samples)
+      : Resampler(input_buffer_samples, output_buffer_samples) {}
+
+  // Resamples the recording as resample() would on a newly initialized resampler, splitting the work into at most
+  // threads parts
+  ResamplerResults resample_split(const uint8_t *input_buffer, uint8_t *output_buffer, size_t input_frames_available,
+                                  size_t output_frames_free, float gain_db, size_t threads);
+
+ protected:
+  // Frames that resample() generates from the input frames, with the output space given
+  size_t expected_output_frames_(size_t input_frames, size_t output_frames_free);
+
+  // Positions a newly initialized resampler on the phase of output frame output_frame of the whole recording. Fed the
+  // recording's (filtered) input from frame *input_start on, it then generates the returned number of frames to
+  // discard, followed by the recording's output from output_frame on.
+  size_t seek_(size_t output_frame, size_t *input_start);
+
+  // Runs only the resampling engine until the output frames are generated or the input runs out, returning the number
+  // of frames generated
+  size_t process_engine_(const float *input, size_t input_frames, float *output, size_t output_frames,
+                         size_t *input_used);
+
+  // Resamples output frames [first, last) of the recording on a new resampler, returning false if it couldn't be
+  // initialized or didn't generate them all
+  bool resample_chunk_(const float *input, size_t input_frames, float *output, size_t first, size_t last);
+
+  // Runs the pre or post biquads over a whole buffer
+  void apply_lowpass_(float *buffer, size_t frames);
+
+  // Starts over and runs resample() on the whole recording
+  ResamplerResults resample_serial_(const uint8_t *input_buffer, uint8_t *output_buffer, size_t input_frames_available,
+                                    size_t output_frames_free, float gain_db);
+
+  ResamplerResults convert_split_(const uint8_t *input_buffer, uint8_t *output_buffer, size_t frames, float gain_db,
+                                  size_t threads);
+};
+
+// Every engine generates an output frame as soon as the input it needs is available, so resample() generates the most
+// frames that the input is enough for
+size_t ChunkResampler::expected_output_frames_(size_t input_frames, size_t output_frames_free) {
+  size_t low = 0, high = output_frames_free;
+
+  while (low < high) {
+    const size_t middle = low + (high - low + 1) / 2;
+
+    if (this->required_input_frames_(middle) <= input_frames) {
+      low = middle;
+    } else {
+      high = middle - 1;
+    }
+  }
+
+  return low;
+}
+
+size_t ChunkResampler::seek_(size_t output_frame, size_t *input_start) {
+  if (this->integer_ratio_) {
+    // A new IntegerResampler's first output falls on its first input frame, and its filters' history is filled after
+    // spanning the final stage's half width (at most 20 frames at the lower rate) and a few frames for the short stage,
+    // which this span always covers
+    const size_t factor = IntegerResampler::get_factor(this->config_.source_sample_rate,
+                                                       this->config_.target_sample_rate);
+    const size_t span = 2 * std::max<size_t>(this->number_of_taps_, 16);
+
+    if (this->config_.target_sample_rate > this->config_.source_sample_rate) {
+      const size_t frame = output_frame / factor;
+
+      *input_start = (frame > span) ? frame - span : 0;
+      return output_frame - *input_start * factor;
+    }
+
+    // a decimator's phase only repeats every factor input frames
+    const size_t frame = output_frame * factor;
+
+    *input_start = (frame > span * factor) ? (frame - span * factor) / factor * factor : 0;
+    return output_frame - *input_start / factor;
+  }
+
+  // The ART filters' window reaches at most number_of_taps_ frames back from an output sample's position, which is
+  // set directly instead
+  const size_t span = this->number_of_taps_;
+  size_t frame;
+  double delta;
+
+  if (this->resampler_->upFactor) {
+    const uint64_t phases = (uint64_t) output_frame * this->resampler_->downFactor;
+    const int phase = (int) (phases % this->resampler_->upFactor);
+
+    frame = (size_t) (phases / this->resampler_->upFactor);
+    *input_start = (frame > span) ? frame - span : 0;
+    art_resampler::resampleAdvancePosition(this->resampler_, (float) (frame - *input_start));
+
+    // rounded to the nearest phase, which is exact
+    if (phase > 0) {
+      art_resampler::resampleAdvancePosition(this->resampler_, (float) phase / this->resampler_->upFactor);
+    }
+
+    return 0;
+  }
+
+  // The position of the k-th output sample is exactly k single precision steps past the first (see
+  // resampleGetRequiredSamples()). With the step as an integer mantissa times a power of two, k steps are computed
+  // exactly in integers (the exponent is never positive for steps below 2^24).
+  int exponent;
+  const float step = 1.0f / this->sample_ratio_;
+  const uint64_t mantissa = (uint64_t) ldexpf(frexpf(step, &exponent), 24);
+  const int fraction_bits = 24 - exponent;
+  const uint64_t steps = (uint64_t) output_frame * mantissa;
+
+  frame = (size_t) (steps >> fraction_bits);
+  *input_start = (frame > span) ? frame - span : 0;
+  delta = (double) (frame - *input_start) + ldexp((double) (steps & ((1ull << fraction_bits) - 1)), -fraction_bits);
+
+  // resampleAdvancePosition() takes a float, so the delta is added in parts that are each exactly a float
+  while (delta > 0.0) {
+    float part = (float) delta;
+
+    if (part > delta) {
+      part = nextafterf(part, 0.0f);
+    }
+
+    art_resampler::resampleAdvancePosition(this->resampler_, part);
+    delta -= part;
+  }
+
+  return 0;
+}
+
+size_t ChunkResampler::process_engine_(const float *input, size_t input_frames, float *output, size_t output_frames,
+                                       size_t *input_used) {
+  size_t generated = 0;
+
+  *input_used = 0;
+
+  while (generated < output_frames) {
+    const size_t input_call_frames = std::min(input_frames, CALL_FRAMES);
+    const size_t output_call_frames = std::min(output_frames - generated, CALL_FRAMES);
+    size_t frames_used, frames_generated;
+
+    if (this->integer_ratio_) {
+      this->integer_resampler_.process(input, input_call_frames, output, output_call_frames, &frames_used,
+                                       &frames_generated);
+    } else {
+      art_resampler::ResampleResult res = art_resampler::resampleProcessInterleaved(
+          this->resampler_, input, input_call_frames, output, output_call_frames, this->sample_ratio_);
+
+      frames_used = res.input_used;
+      frames_generated = res.output_generated;
+    }
+
+    if ((frames_used == 0) && (frames_generated == 0)) {
+      break;
+    }
+
+    input += frames_used * this->channels_;
+    input_frames -= frames_used;
+    *input_used += frames_used;
+    output += frames_generated * this->channels_;
+    generated += frames_generated;
+  }
+
+  return generated;
+}
+
+bool ChunkResampler::resample_chunk_(const float *input, size_t input_frames, float *output, size_t first,
+                                     size_t last) {
+  ChunkResampler chunk(this->input_buffer_samples_, this->output_buffer_samples_);
+  ResamplerConfiguration config = this->config_;
+
+  if (!chunk.initialize(config)) {
+    return false;
+  }
+
+  size_t input_start, input_used;
+  const size_t discard = chunk.seek_(first, &input_start);
+
+  input += input_start * this->channels_;
+  input_frames -= input_start;
+
+  if (discard > 0) {
+    float *scratch = (float *) internal::alloc_psram_fallback(discard * this->channels_ * sizeof(float));
+
+    if (scratch == nullptr) {
+      return false;
+    }
+
+    const size_t generated = chunk.process_engine_(input, input_frames, scratch, discard, &input_used);
+    internal::free_psram_fallback(scratch);
+
+    if (generated != discard) {
+      return false;
+    }
+
+    input += input_used * this->channels_;
+    input_frames -= input_used;
+  }
+
+  return chunk.process_engine_(input, input_frames, output + first * this->channels_, last - first, &input_used) ==
+         last - first;
+}
+
+void ChunkResampler::apply_lowpass_(float *buffer, size_t frames) {
+  for (size_t start = 0; start < frames; start += CALL_FRAMES) {
+    art_resampler::biquad_cascade_apply_interleaved(&this->lowpass_, buffer + start * this->channels_,
+                                                    std::min(frames - start, CALL_FRAMES));
+  }
+}
+
+ResamplerResults ChunkResampler::resample_serial_(const uint8_t *input_buffer, uint8_t *output_buffer,
+                                                  size_t input_frames_available, size_t output_frames_free,
+                                                  float gain_db) {
+  ResamplerConfiguration config = this->config_;
+
+  if (!this->initialize(config)) {
+    ResamplerResults results = {.frames_used = 0, .frames_generated = 0, .predicted_frames_used = 0,
+                                .clipped_samples = 0};
+    return results;
+  }
+
+  return this->resample(input_buffer, output_buffer, input_frames_available, output_frames_free, gain_db);
+}
+
+ResamplerResults ChunkResampler::convert_split_(const uint8_t *input_buffer, uint8_t *output_buffer, size_t frames,
+                                                float gain_db, size_t threads) {
+  const size_t input_frame_bytes = this->channels_ * ((this->input_bits_ + 7) / 8);
+  const size_t output_frame_bytes = this->channels_ * ((this->output_bits_ + 7) / 8);
+  const size_t parts = count_parts(frames, threads);
+  std::vector<uint32_t> clipped(parts, 0);
+
+  run_parts(parts, [&](size_t part) {
+    const size_t last = part_start(frames, parts, part + 1);
+
+    for (size_t start = part_start(frames, parts, part); start < last; start += CALL_FRAMES) {
+      clipped[part] += quantization_utils::quantized_to_quantized(
+          input_buffer + start * input_frame_bytes, output_buffer + start * output_frame_bytes,
+          std::min(last - start, CALL_FRAMES) * this->channels_, this->input_bits_, this->output_bits_, gain_db);
+    }
+  });
+
+  ResamplerResults results = {.frames_used = frames, .frames_generated = frames, .predicted_frames_used = frames,
+                              .clipped_samples = 0};
+
+  for (uint32_t count : clipped) {
+    results.clipped_samples += count;
+  }
+
+  return results;
+}
+
+// The stages between the sample conversions run over the whole recording at once, in float buffers. Each stage gives
+// the same result however its input is divided up, so only the resampling engine's state has to be recreated at the
+// start of each chunk.
+ResamplerResults ChunkResampler::resample_split(const uint8_t *input_buffer, uint8_t *output_buffer,
+                                                size_t input_frames_available, size_t output_frames_free,
+                                                float gain_db, size_t threads) {
+  if (!this->requires_resampling_) {
+    return this->convert_split_(input_buffer, output_buffer, std::min(input_frames_available, output_frames_free),
+                                gain_db, threads);
+  }
+
+  const size_t frames_to_process =
+      std::min(input_frames_available, this->required_input_frames_(output_frames_free));
+  const size_t frames_generated = this->expected_output_frames_(frames_to_process, output_frames_free);
+  const size_t parts = count_parts(frames_generated, threads);
+
+  if (this->asrc_ || (this->fixed_sample_bytes_ > 0) || this->interpolate_ || (parts < 2)) {
+    return this->resample(input_buffer, output_buffer, input_frames_available, output_frames_free, gain_db);
+  }
+
+  const size_t channels = this->channels_;
+  float *input = (float *) internal::alloc_psram_fallback(frames_to_process * channels * sizeof(float));
+  float *output = (float *) internal::alloc_psram_fallback(frames_generated * channels * sizeof(float));
+
+  if ((input == nullptr) || (output == nullptr)) {
+    internal::free_psram_fallback(input);
+    internal::free_psram_fallback(output);
+    return this->resample(input_buffer, output_buffer, input_frames_available, output_frames_free, gain_db);
+  }
+
+  const size_t input_frame_bytes = channels * ((this->input_bits_ + 7) / 8);
+  const size_t output_frame_bytes = channels * ((this->output_bits_ + 7) / 8);
+  const size_t input_parts = count_parts(frames_to_process, threads);
+
+  run_parts(input_parts, [&](size_t part) {
+    const size_t last = part_start(frames_to_process, input_parts, part + 1);
+
+    for (size_t start = part_start(frames_to_process, input_parts, part); start < last; start += CALL_FRAMES) {
+      quantization_utils::quantized_to_float(input_buffer + start * input_frame_bytes, input + start * channels,
+                                             std::min(last - start, CALL_FRAMES) * channels, this->input_bits_,
+                                             gain_db);
+    }
+  });
+
+  if (this->pre_filter_) {
+    this->apply_lowpass_(input, frames_to_process);
+  }
+
+  std::atomic<bool> success{true};
+
+  run_parts(parts, [&](size_t part) {
+    if (!this->resample_chunk_(input, frames_to_process, output, part_start(frames_generated, parts, part),
+                               part_start(frames_generated, parts, part + 1))) {
+      success = false;
+    }
+  });
+
+  internal::free_psram_fallback(input);
+
+  if (!success) {
+    internal::free_psram_fallback(output);
+    return this->resample_serial_(input_buffer, output_buffer, input_frames_available, output_frames_free, gain_db);
+  }
+
+  if (this->post_filter_) {
+    this->apply_lowpass_(output, frames_generated);
+  }
+
+  std::vector<uint32_t> clipped(parts, 0);
+
+  run_parts(parts, [&](size_t part) {
+    const size_t last = part_start(frames_generated, parts, part + 1);
+
+    for (size_t start = part_start(frames_generated, parts, part); start < last; start += CALL_FRAMES) {
+      clipped[part] += quantization_utils::float_to_quantized(output + start * channels,
+                                                              output_buffer + start * output_frame_bytes,
+                                                              std::min(last - start, CALL_FRAMES) * channels,
+                                                              this->output_bits_);
+    }
+  });
+
+  internal::free_psram_fallback(output);
+
+  ResamplerResults results = {.frames_used = frames_to_process,
+                              .frames_generated = frames_generated,
+                              .predicted_frames_used = frames_to_process,
+                              .clipped_samples = 0};
+
+  for (uint32_t count : clipped) {
+    results.clipped_samples += count;
+  }
+
+  return results;
+}
+
+ParallelResampler::ParallelResampler(size_t threads) : threads_(threads) {
+  if (this->threads_ == 0) {
+    this->threads_ = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+}
+
+bool ParallelResampler::initialize(ResamplerConfiguration &config) {
+  Resampler resampler(config.channels, config.channels);  // only checks that the configuration can be used
+
+  this->config_ = config;
+  this->initialized_ = resampler.initialize(config);
+
+  return this->initialized_;
+}
+
+ResamplerResults ParallelResampler::resample(const uint8_t *input_buffer, uint8_t *output_buffer,
+                                             size_t input_frames_available, size_t output_frames_free,
+                                             float gain_db) {
+  ChunkResampler resampler(input_frames_available * this->config_.channels,
+                           output_frames_free * this->config_.channels);
+
+  if (!this->initialized_ || !resampler.initialize(this->config_)) {
+    ResamplerResults results = {.frames_used = 0, .frames_generated = 0, .predicted_frames_used = 0,
+                                .clipped_samples = 0};
+    return results;
+  }
+
+  return resampler.resample_split(input_buffer, output_buffer, input_frames_available, output_frames_free, gain_db,
+                                  this->threads_);
+}
+
+}  // namespace resampler
+}  // namespace esp_audio_libs
@@ -5,156 +5,577 @@
 namespace esp_audio_libs {
 namespace resampler {
 
-Resampler::~Resampler() {
+// Maximum number of frames carried through all the processing stages at once. Small enough that a tile of stereo float
+// samples (1 KB) stays in cache from the sample conversion through the filters and resampler to the quantizer.
+static const size_t TILE_FRAMES = 128;
+
+// Cutoff of the single biquad used with interpolation, relative to the lower Nyquist frequency. It can't be sharp, so
+// it starts rolling off a little early.
+static const float INTERPOLATION_LOWPASS_RATIO = 0.9f;
+
+// Reduces the ratio of two integral sample rates to lowest terms. Returns false if either rate isn't an integer or if
+// the reduced ratio needs more phases than the ART resampler supports.
+static bool get_rational_factors(float source_sample_rate, float target_sample_rate, uint32_t *up_factor,
+                                 uint32_t *down_factor) {
+  if ((source_sample_rate < 1.0f) || (target_sample_rate < 1.0f) ||
+      (floorf(source_sample_rate) != source_sample_rate) || (floorf(target_sample_rate) != target_sample_rate)) {
+    return false;
+  }
+
+  uint32_t a = (uint32_t) target_sample_rate;
+  uint32_t b = (uint32_t) source_sample_rate;
+  while (b != 0) {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+
+  *up_factor = (uint32_t) target_sample_rate / a;
+  *down_factor = (uint32_t) source_sample_rate / a;
+
+  return *up_factor <= 1024;
+}
+
+// Group delay of a biquad at DC, in samples: the centroid of the numerator minus that of the denominator
+static float biquad_dc_delay(const art_resampler::BiquadCoefficients &coeffs) {
+  return (coeffs.a1 + 2.0f * coeffs.a2) / (coeffs.a0 + coeffs.a1 + coeffs.a2) -
+         (coeffs.b1 + 2.0f * coeffs.b2) / (1.0f + coeffs.b1 + coeffs.b2);
+}
+
+Resampler::~Resampler() { this->free_buffers_(); }
+
+void Resampler::free_buffers_() {
   if (this->resampler_ != nullptr) {
     art_resampler::resampleFree(this->resampler_);
+    this->resampler_ = nullptr;
+  }
+
+  this->integer_resampler_.release();
+  this->interpolating_resampler_.release();
+
+  internal::free_psram_fallback(this->float_input_buffer_);
+  internal::free_psram_fallback(this->float_output_buffer_);
+  internal::free_psram_fallback(this->fixed_input_buffer_);
+  internal::free_psram_fallback(this->fixed_output_buffer_);
+  internal::free_psram_fallback(this->lowpass_state_);
+
+  this->float_input_buffer_ = nullptr;
+  this->float_output_buffer_ = nullptr;
+  this->fixed_input_buffer_ = nullptr;
+  this->fixed_output_buffer_ = nullptr;
+  this->lowpass_state_ = nullptr;
+}
+
+// The scratch buffers are only needed for resampling, so they're allocated when it's first configured
+bool Resampler::allocate_buffers_() {
+  const size_t input_tile_samples = this->input_tile_frames_ * this->channels_;
+  const size_t output_tile_samples = this->output_tile_frames_ * this->channels_;
+
+  if (this->fixed_sample_bytes_ > 0) {
+    if (this->fixed_input_buffer_ == nullptr) {
+      this->fixed_input_buffer_ = internal::alloc_psram_fallback(input_tile_samples * this->fixed_sample_bytes_);
+    }
+    if (this->fixed_output_buffer_ == nullptr) {
+      this->fixed_output_buffer_ = internal::alloc_psram_fallback(output_tile_samples * this->fixed_sample_bytes_);
+    }
+
+    return (this->fixed_input_buffer_ != nullptr) && (this->fixed_output_buffer_ != nullptr);
   }
 
-  if (this->float_input_buffer_ != nullptr) {
-    internal::free_psram_fallback(this->float_input_buffer_);
+  if (this->float_input_buffer_ == nullptr) {
+    this->float_input_buffer_ = (float *) internal::alloc_psram_fallback(input_tile_samples * sizeof(float));
   }
-  if (this->float_output_buffer_ != nullptr) {
-    internal::free_psram_fallback(this->float_output_buffer_);
+  if (this->float_output_buffer_ == nullptr) {
+    this->float_output_buffer_ = (float *) internal::alloc_psram_fallback(output_tile_samples * sizeof(float));
   }
-};
+  if (this->lowpass_state_ == nullptr) {
+    this->lowpass_state_ = (float *) internal::alloc_psram_fallback(
+        BIQUAD_CASCADE_STATE_SIZE(2, this->channels_) * sizeof(float));
+  }
+
+  return (this->float_input_buffer_ != nullptr) && (this->float_output_buffer_ != nullptr) &&
+         (this->lowpass_state_ != nullptr);
+}
 
 bool Resampler::initialize(ResamplerConfiguration &config) {
+  // Release anything allocated by a previous call and start over from the default state
+  this->free_buffers_();
+  this->fixed_sample_bytes_ = 0;
+  this->sample_ratio_ = this->nominal_ratio_ = 1.0f;
+  this->pre_filter_ = this->post_filter_ = this->requires_resampling_ = this->integer_ratio_ = false;
+  this->interpolate_ = false;
+  this->asrc_ = this->asrc_primed_ = false;
+  this->asrc_trim_ = this->asrc_integral_ = 0.0f;
+  this->asrc_frames_generated_ = 0;
+  this->last_input_frames_ = this->last_output_frames_ = 0;
+
+  this->config_ = config;
   this->input_bits_ = config.source_bits_per_sample;
   this->output_bits_ = config.target_bits_per_sample;
   this->channels_ = config.channels;
   this->number_of_taps_ = config.number_of_taps;
   this->number_of_filters_ = config.number_of_filters;
 
-  this->float_input_buffer_ =
-      (float *) internal::alloc_psram_fallback(this->input_buffer_samples_ * sizeof(float));
+  // The scratch buffers only hold one tile, or less if the caller's buffers are smaller than that
+  this->input_tile_frames_ = std::min(TILE_FRAMES, std::max<size_t>(this->input_buffer_samples_ / this->channels_, 1));
+  this->output_tile_frames_ =
+      std::min(TILE_FRAMES, std::max<size_t>(this->output_buffer_samples_ / this->channels_, 1));
+
+  if (config.use_fixed_point) {
+    this->fixed_sample_bytes_ = ((this->input_bits_ <= 16) && (this->output_bits_ <= 16)) ? 2 : 4;
+  }
+
+  // ASRC always runs the resampler, as the trimmed ratio moves away from unity even for matching nominal rates.
+  // Otherwise the samples are only converted, directly between the integer formats.
+  if ((config.source_sample_rate != config.target_sample_rate) || config.use_asrc) {
+    if (!this->allocate_buffers_()) {
+      return false;
+    }
+
+    // Integer ratios use the polyphase half-band engine, which has no fixed-point path, ratio trim, or low-latency
+    // filters
+    if (!config.use_fixed_point && !config.use_asrc && !config.use_low_latency &&
+        (config.interpolation_mode == INTERPOLATION_SINC) &&
+        (IntegerResampler::get_factor(config.source_sample_rate, config.target_sample_rate) != 0)) {
+      this->integer_ratio_ = this->requires_resampling_ = true;
+      this->sample_ratio_ = this->nominal_ratio_ = config.target_sample_rate / config.source_sample_rate;
+
+      return this->integer_resampler_.initialize(config.source_sample_rate, config.target_sample_rate, config.channels,
+                                                 config.number_of_taps);
+    }
+
+    return this->configure_ratio_(config);
+  }
 
-  this->float_output_buffer_ =
-      (float *) internal::alloc_psram_fallback(this->output_buffer_samples_ * sizeof(float));
+  return true;
+}
 
-  if ((this->float_input_buffer_ == nullptr) || (this->float_output_buffer_ == nullptr)) {
+bool Resampler::reconfigure(ResamplerConfiguration &config) {
+  // The history and scratch buffers are laid out for the channel count, tap count, and sample format
+  if ((config.channels != this->channels_) || (config.number_of_taps != this->number_of_taps_) ||
+      (config.use_fixed_point != this->config_.use_fixed_point) ||
+      (config.use_low_latency != this->config_.use_low_latency) ||
+      (config.interpolation_mode != this->config_.interpolation_mode)) {
     return false;
   }
 
-  if (config.source_sample_rate != config.target_sample_rate) {
-    this->requires_resampling_ = true;
-    int flags = 0;
+  if (config.use_fixed_point &&
+      (((config.source_bits_per_sample <= 16) && (config.target_bits_per_sample <= 16)) !=
+       (this->fixed_sample_bytes_ == 2))) {
+    return false;
+  }
+
+  // The integer-ratio engine can't switch to other rates
+  if (this->integer_ratio_) {
+    if ((config.source_sample_rate != this->config_.source_sample_rate) ||
+        (config.target_sample_rate != this->config_.target_sample_rate) || config.use_asrc) {
+      return false;
+    }
+  } else if ((config.source_sample_rate != config.target_sample_rate) || config.use_asrc ||
+             (this->resampler_ != nullptr)) {
+    // Once a resampler is running it's kept even if the new rates match, so the samples in its history aren't lost
+    if (!this->allocate_buffers_()) {
+      return false;
+    }
 
-    if (config.subsample_interpolate) {
-      flags |= SUBSAMPLE_INTERPOLATE;
+    if (!this->configure_ratio_(config)) {
+      return false;
     }
+  }
+
+  this->config_ = config;
+  this->input_bits_ = config.source_bits_per_sample;
+  this->output_bits_ = config.target_bits_per_sample;
+  this->number_of_filters_ = config.number_of_filters;
 
-    this->sample_ratio_ = config.target_sample_rate / config.source_sample_rate;
+  return true;
+}
 
-    if (this->sample_ratio_ < 1.0f) {
-      this->lowpass_ratio_ -= (10.24f / this->number_of_taps_);
+bool Resampler::set_ratio(float source_sample_rate, float target_sample_rate) {
+  ResamplerConfiguration config = this->config_;
 
-      if (this->lowpass_ratio_ < 0.84f) {
-        this->lowpass_ratio_ = 0.84f;
-      }
+  config.source_sample_rate = source_sample_rate;
+  config.target_sample_rate = target_sample_rate;
 
-      if (this->lowpass_ratio_ < this->sample_ratio_) {
-        // avoid discontinuities near unity sample ratios
-        this->lowpass_ratio_ = this->sample_ratio_;
-      }
+  return this->reconfigure(config);
+}
+
+bool Resampler::configure_ratio_(ResamplerConfiguration &config) {
+  const float sample_ratio = config.target_sample_rate / config.source_sample_rate;
+  const bool interpolate = (config.interpolation_mode != INTERPOLATION_SINC) && !config.use_fixed_point;
+  float lowpass_ratio = 1.0f;
+  int flags = 0;
+
+  if (config.use_fixed_point) {
+    flags |= FIXED_POINT;
+  }
+
+  if (config.subsample_interpolate) {
+    flags |= SUBSAMPLE_INTERPOLATE;
+  }
+
+  if (config.use_low_latency) {
+    flags |= LOW_LATENCY;
+  }
+
+  if (interpolate) {
+    lowpass_ratio = INTERPOLATION_LOWPASS_RATIO;
+  } else if (sample_ratio < 1.0f) {
+    lowpass_ratio -= (10.24f / config.number_of_taps);
+
+    if (lowpass_ratio < 0.84f) {
+      lowpass_ratio = 0.84f;
     }
-    if (this->lowpass_ratio_ * this->sample_ratio_ < 0.98f && config.use_pre_or_post_filter) {
-      float cutoff = this->lowpass_ratio_ * this->sample_ratio_ / 2.0f;
-      art_resampler::biquad_lowpass(&this->lowpass_coeff_, cutoff);
-      this->pre_filter_ = true;
+
+    if (lowpass_ratio < sample_ratio) {
+      // avoid discontinuities near unity sample ratios
+      lowpass_ratio = sample_ratio;
     }
+  }
 
-    if (this->lowpass_ratio_ / this->sample_ratio_ < 0.98f && config.use_pre_or_post_filter && !this->pre_filter_) {
-      float cutoff = this->lowpass_ratio_ / this->sample_ratio_ / 2.0f;
-      art_resampler::biquad_lowpass(&this->lowpass_coeff_, cutoff);
-      this->post_filter_ = true;
+  float lowpass = 1.0f;
+
+  if (sample_ratio < 1.0f) {
+    lowpass = sample_ratio * lowpass_ratio;
+    flags |= INCLUDE_LOWPASS;
+  } else if (lowpass_ratio < 1.0f) {
+    lowpass = lowpass_ratio;
+    flags |= INCLUDE_LOWPASS;
+  }
+
+  uint32_t up_factor, down_factor;
+  bool success;
+
+  // the ratio of a rational context is fixed, so it can't be trimmed by the ASRC loop
+  const bool rational =
+      config.use_rational_ratio && !config.use_asrc &&
+      get_rational_factors(config.source_sample_rate, config.target_sample_rate, &up_factor, &down_factor);
+
+  if (interpolate) {
+    success = this->interpolating_resampler_.is_initialized() ||
+              this->interpolating_resampler_.initialize(config.channels, (InterpolationMode) config.interpolation_mode);
+  } else if (this->resampler_ == nullptr) {
+    if (rational) {
+      this->resampler_ = art_resampler::resampleInitRational(config.channels, config.number_of_taps, up_factor,
+                                                             down_factor, lowpass, flags);
+    } else {
+      this->resampler_ = art_resampler::resampleInit(config.channels, config.number_of_taps, config.number_of_filters,
+                                                     lowpass, flags);
     }
 
-    if (this->pre_filter_ || this->post_filter_) {
-      for (int i = 0; i < this->channels_; ++i) {
-        art_resampler::biquad_init(&this->lowpass_[i][0], &this->lowpass_coeff_, 1.0f);
-        art_resampler::biquad_init(&this->lowpass_[i][1], &this->lowpass_coeff_, 1.0f);
-      }
+    success = (this->resampler_ != nullptr);
+
+    if (success) {
+      // skip the filter lookahead (a quarter of the taps for LOW_LATENCY) to align the output with the input
+      art_resampler::resampleAdvancePosition(this->resampler_,
+                                             config.number_of_taps / (config.use_low_latency ? 4.0f : 2.0f));
     }
+  } else if (rational) {
+    success = art_resampler::resampleSetFiltersRational(this->resampler_, up_factor, down_factor, lowpass, flags);
+  } else {
+    success = art_resampler::resampleSetFilters(this->resampler_, config.number_of_filters, lowpass, flags);
+  }
+
+  if (!success) {
+    return false;
+  }
+
+  // The optional biquad runs before the resampler when its cutoff is below the output Nyquist, or after it when below
+  // the input Nyquist. If it stays in the same place its state is kept so a ratio change doesn't click.
+  art_resampler::BiquadCoefficients lowpass_coeff;
+  bool pre_filter = false;
+  bool post_filter = false;
+
+  if (lowpass_ratio * sample_ratio < 0.98f && config.use_pre_or_post_filter && !config.use_fixed_point) {
+    art_resampler::biquad_lowpass(&lowpass_coeff, lowpass_ratio * sample_ratio / 2.0f);
+    pre_filter = true;
+  } else if (lowpass_ratio / sample_ratio < 0.98f && config.use_pre_or_post_filter && !config.use_fixed_point) {
+    art_resampler::biquad_lowpass(&lowpass_coeff, lowpass_ratio / sample_ratio / 2.0f);
+    post_filter = true;
+  }
+
+  const uint8_t stages = interpolate ? 1 : 2;
 
-    if (this->sample_ratio_ < 1.0f) {
-      this->resampler_ =
-          art_resampler::resampleInit(this->channels_, this->number_of_taps_, this->number_of_filters_,
-                                      this->sample_ratio_ * this->lowpass_ratio_, flags | INCLUDE_LOWPASS);
-    } else if (this->lowpass_ratio_ < 1.0f) {
-      this->resampler_ = art_resampler::resampleInit(this->channels_, this->number_of_taps_, this->number_of_filters_,
-                                                     this->lowpass_ratio_, flags | INCLUDE_LOWPASS);
+  if (pre_filter || post_filter) {
+    const bool keep_state = (pre_filter == this->pre_filter_) && (post_filter == this->post_filter_) &&
+                            (stages == this->lowpass_.num_sections);
+
+    if (keep_state) {
+      for (int j = 0; j < stages; ++j) {
+        art_resampler::biquad_cascade_set_section(&this->lowpass_, j, &lowpass_coeff);
+      }
     } else {
-      this->resampler_ =
-          art_resampler::resampleInit(this->channels_, this->number_of_taps_, this->number_of_filters_, 1.0f, flags);
-    }
+      // A biquad starting mid-stream is primed with the last sample that went through its place in the pipeline (the
+      // previous tile is still in the scratch buffer), as if it had been held there
+      const float *history = pre_filter ? this->float_input_buffer_ : this->float_output_buffer_;
+      const size_t history_frames = pre_filter ? this->last_input_frames_ : this->last_output_frames_;
 
-    if (this->resampler_ == nullptr) {
-      return false;
+      for (int j = 0; j < stages; ++j) {
+        this->lowpass_coeffs_[j] = lowpass_coeff;
+      }
+
+      art_resampler::biquad_cascade_init(&this->lowpass_, this->lowpass_coeffs_, stages, this->lowpass_state_,
+                                         config.channels);
+
+      if ((history != nullptr) && (history_frames >= 1)) {
+        art_resampler::biquad_cascade_prime(&this->lowpass_, history + (history_frames - 1) * config.channels);
+      }
     }
-    art_resampler::resampleAdvancePosition(this->resampler_, this->number_of_taps_ / 2.0f);
   }
 
+  this->pre_filter_ = pre_filter;
+  this->post_filter_ = post_filter;
+  this->lowpass_stages_ = stages;
+  this->lowpass_ratio_ = lowpass_ratio;
+  this->interpolate_ = interpolate;
+  this->requires_resampling_ = true;
+
+  // The ASRC trim tracks the drift between the clocks, which doesn't depend on the nominal rates, so it's kept
+  if (config.use_asrc) {
+    const uint16_t max_ppm = config.asrc_max_ppm ? config.asrc_max_ppm : 1000;
+    const uint16_t response_ms = config.asrc_response_ms ? config.asrc_response_ms : 2000;
+
+    this->asrc_ = true;
+    this->asrc_target_frames_ = config.asrc_target_frames;
+    this->asrc_max_trim_ = max_ppm * 1e-6f;
+    this->asrc_bandwidth_ = 1000.0f / (response_ms * config.target_sample_rate);
+    this->asrc_trim_ = std::max(std::min(this->asrc_trim_, this->asrc_max_trim_), -this->asrc_max_trim_);
+  } else {
+    this->asrc_ = false;
+    this->asrc_trim_ = 0.0f;
+  }
+
+  this->nominal_ratio_ = sample_ratio;
+  this->sample_ratio_ = sample_ratio * (1.0f + this->asrc_trim_);
+
   return true;
 }
 
 ResamplerResults Resampler::resample(const uint8_t *input_buffer, uint8_t *output_buffer, size_t input_frames_available,
                                      size_t output_frames_free, float gain_db) {
-  size_t frames_to_process = input_frames_available;
+  if (!this->requires_resampling_) {
+    // Only the bit depth and gain change, so convert the integer samples directly in one pass
+    const size_t frames = std::min(input_frames_available, output_frames_free);
+    const uint32_t clipped_samples = quantization_utils::quantized_to_quantized(
+        input_buffer, output_buffer, frames * this->channels_, this->input_bits_, this->output_bits_, gain_db);
 
-  if (this->requires_resampling_) {
-    const size_t necessary_frames =
-        art_resampler::resampleGetRequiredSamples(this->resampler_, output_frames_free, this->sample_ratio_);
-    frames_to_process = std::min(frames_to_process, necessary_frames);
-  } else {
-    frames_to_process = std::min(frames_to_process, output_frames_free);
+    ResamplerResults results = {.frames_used = frames,
+                                .frames_generated = frames,
+                                .predicted_frames_used = frames,
+                                .clipped_samples = clipped_samples};
+    return results;
   }
-  uint32_t conversion_time = 0;
-  if (this->requires_resampling_) {
-    quantization_utils::quantized_to_float(input_buffer, this->float_input_buffer_, frames_to_process * this->channels_,
-                                           this->input_bits_, gain_db);
-  } else {
-    // Just converting the bits per sample
-    quantization_utils::quantized_to_float(input_buffer, this->float_output_buffer_,
-                                           frames_to_process * this->channels_, this->input_bits_, gain_db);
+
+  const size_t frames_to_process =
+      std::min(input_frames_available, this->required_input_frames_(output_frames_free));
+
+  const size_t input_frame_bytes = this->channels_ * ((this->input_bits_ + 7) / 8);
+  const size_t output_frame_bytes = this->channels_ * ((this->output_bits_ + 7) / 8);
+
+  ResamplerResults results = {.frames_used = 0,
+                              .frames_generated = 0,
+                              .predicted_frames_used = frames_to_process,
+                              .clipped_samples = 0};
+
+  // Every stage runs over one tile before moving on to the next, so the tile stays in cache between stages. Each
+  // tile is sized for the output space left, so the resampler consumes all of the tile's input.
+  while (true) {
+    size_t input_frames = std::min(frames_to_process - results.frames_used, this->input_tile_frames_);
+    const size_t output_frames = std::min(output_frames_free - results.frames_generated, this->output_tile_frames_);
+
+    input_frames = std::min(input_frames, this->required_input_frames_(output_frames));
+
+    const uint8_t *tile_input = input_buffer + results.frames_used * input_frame_bytes;
+    uint8_t *tile_output = output_buffer + results.frames_generated * output_frame_bytes;
+
+    ResamplerResults tile;
+
+    if (this->fixed_sample_bytes_ > 0) {
+      tile = this->resample_fixed_tile_(tile_input, tile_output, input_frames, output_frames, gain_db);
+    } else {
+      tile = this->resample_tile_(tile_input, tile_output, input_frames, output_frames, gain_db);
+    }
+
+    if ((tile.frames_used == 0) && (tile.frames_generated == 0)) {
+      break;
+    }
+
+    results.frames_used += tile.frames_used;
+    results.frames_generated += tile.frames_generated;
+    results.clipped_samples += tile.clipped_samples;
+  }
+
+  this->asrc_frames_generated_ += results.frames_generated;
+
+  return results;
+}
+
+// The sink buffer level integrates the difference between the rate output is generated at and the rate the sink
+// consumes it, so a PI controller on the level error (in output frames) locks the trimmed ratio to the sink clock and
+// returns the level to its target. With the loop natural frequency w in radians per output frame, the gains
+// Kp = 2w, Ki = w^2 give a critically damped response. The reported level is jittery (the sink drains in DMA-sized
+// bursts), so it is smoothed first with a time constant of an eighth of the loop's, which is fast enough not to affect
+// the loop's stability. The integrator is clamped so it can't wind up past the trim limit.
+void Resampler::update_buffer_level(size_t buffered_frames) {
+  if (!this->asrc_) {
+    return;
+  }
+
+  const float error = (float) buffered_frames - (float) this->asrc_target_frames_;
+  const float elapsed = (float) this->asrc_frames_generated_;
+  const float bandwidth = this->asrc_bandwidth_;
+
+  this->asrc_frames_generated_ = 0;
+
+  if (!this->asrc_primed_) {
+    this->asrc_filtered_error_ = error;
+    this->asrc_primed_ = true;
+    return;
+  }
+
+  if (elapsed == 0.0f) {
+    return;
+  }
+
+  this->asrc_filtered_error_ += (error - this->asrc_filtered_error_) * std::min(elapsed * bandwidth * 8.0f, 1.0f);
+
+  const float integral_limit = this->asrc_max_trim_ / (bandwidth * bandwidth);
+  this->asrc_integral_ = std::max(
+      std::min(this->asrc_integral_ + this->asrc_filtered_error_ * elapsed, integral_limit), -integral_limit);
+
+  const float trim = -(2.0f * bandwidth * this->asrc_filtered_error_ + bandwidth * bandwidth * this->asrc_integral_);
+  this->asrc_trim_ = std::max(std::min(trim, this->asrc_max_trim_), -this->asrc_max_trim_);
+  this->sample_ratio_ = this->nominal_ratio_ * (1.0f + this->asrc_trim_);
+}
+
+size_t Resampler::required_input_frames_(size_t output_frames) {
+  if (this->integer_ratio_) {
+    return this->integer_resampler_.required_input(output_frames);
+  }
+
+  if (this->interpolate_) {
+    return this->interpolating_resampler_.required_input(output_frames, this->sample_ratio_);
   }
 
-  size_t frames_used = frames_to_process;
-  size_t frames_generated = frames_to_process;
-  size_t predicted_frames_used = frames_to_process;
+  return art_resampler::resampleGetRequiredSamples(this->resampler_, output_frames, this->sample_ratio_);
+}
+
+// The ART filters delay the signal by their lookahead (in input samples), and each of the cascaded biquads by its own
+// group delay at the rate it runs at
+float Resampler::latency_frames() const {
+  if (!this->requires_resampling_) {
+    return 0.0f;
+  }
+
+  if (this->integer_ratio_) {
+    return this->integer_resampler_.latency_frames();
+  }
+
+  float latency = this->interpolate_ ? this->interpolating_resampler_.latency_frames() * this->sample_ratio_
+                                    : art_resampler::resampleGetLatency(this->resampler_) * this->sample_ratio_;
+
+  if (this->pre_filter_) {
+    latency += this->lowpass_stages_ * biquad_dc_delay(this->lowpass_coeffs_[0]) * this->sample_ratio_;
+  } else if (this->post_filter_) {
+    latency += this->lowpass_stages_ * biquad_dc_delay(this->lowpass_coeffs_[0]);
+  }
+
+  return latency;
+}
+
+ResamplerResults Resampler::resample_tile_(const uint8_t *input_buffer, uint8_t *output_buffer, size_t input_frames,
+                                           size_t output_frames, float gain_db) {
+  quantization_utils::quantized_to_float(input_buffer, this->float_input_buffer_, input_frames * this->channels_,
+                                         this->input_bits_, gain_db);
+
+  float *output = this->float_output_buffer_;
+  size_t frames_used, frames_generated;
 
-  if (this->requires_resampling_) {
+  if (this->integer_ratio_) {
+    this->integer_resampler_.process(this->float_input_buffer_, input_frames, output, output_frames, &frames_used,
+                                     &frames_generated);
+  } else {
     if (this->pre_filter_) {
-      for (int i = 0; i < this->channels_; ++i) {
-        art_resampler::biquad_apply_buffer(&this->lowpass_[i][0], this->float_input_buffer_ + i, frames_to_process,
-                                           this->channels_);
-        art_resampler::biquad_apply_buffer(&this->lowpass_[i][1], this->float_input_buffer_ + i, frames_to_process,
-                                           this->channels_);
-      }
+      art_resampler::biquad_cascade_apply_interleaved(&this->lowpass_, this->float_input_buffer_, input_frames);
     }
 
-    art_resampler::ResampleResult res =
-        art_resampler::resampleProcessInterleaved(this->resampler_, this->float_input_buffer_, frames_to_process,
-                                                  this->float_output_buffer_, output_frames_free, this->sample_ratio_);
+    if (this->interpolate_) {
+      this->interpolating_resampler_.process(this->float_input_buffer_, input_frames, output, output_frames,
+                                             this->sample_ratio_, &frames_used, &frames_generated);
+    } else {
+      art_resampler::ResampleResult res = art_resampler::resampleProcessInterleaved(
+          this->resampler_, this->float_input_buffer_, input_frames, output, output_frames, this->sample_ratio_);
 
-    frames_used = res.input_used;
-    frames_generated = res.output_generated;
+      frames_used = res.input_used;
+      frames_generated = res.output_generated;
+    }
 
     if (this->post_filter_) {
-      for (int i = 0; i < this->channels_; ++i) {
-        art_resampler::biquad_apply_buffer(&this->lowpass_[i][0], this->float_output_buffer_ + i, frames_generated,
-                                           this->channels_);
-        art_resampler::biquad_apply_buffer(&this->lowpass_[i][1], this->float_output_buffer_ + i, frames_generated,
-                                           this->channels_);
-      }
+      art_resampler::biquad_cascade_apply_interleaved(&this->lowpass_, output, frames_generated);
     }
   }
 
-  uint32_t clipped_samples = quantization_utils::float_to_quantized(
-      this->float_output_buffer_, output_buffer, frames_generated * this->channels_, this->output_bits_);
+  // remembered in case a biquad has to be started up on these samples by a reconfigure
+  if (input_frames > 0) {
+    this->last_input_frames_ = input_frames;
+  }
+  if (frames_generated > 0) {
+    this->last_output_frames_ = frames_generated;
+  }
+
+  uint32_t clipped_samples = quantization_utils::float_to_quantized(output, output_buffer,
+                                                                     frames_generated * this->channels_,
+                                                                     this->output_bits_);
 
   ResamplerResults results = {.frames_used = frames_used,
                               .frames_generated = frames_generated,
-                              .predicted_frames_used = frames_to_process,
+                              .predicted_frames_used = input_frames,
+                              .clipped_samples = clipped_samples};
+  return results;
+}
+
+ResamplerResults Resampler::resample_fixed_tile_(const uint8_t *input_buffer, uint8_t *output_buffer,
+                                                 size_t input_frames, size_t output_frames, float gain_db) {
+  size_t frames_used, frames_generated;
+  uint32_t clipped_samples = 0;
+
+  if (this->fixed_sample_bytes_ == 2) {
+    int16_t *input = (int16_t *) this->fixed_input_buffer_;
+    int16_t *output = (int16_t *) this->fixed_output_buffer_;
+
+    clipped_samples += quantization_utils::quantized_to_fixed16(input_buffer, input, input_frames * this->channels_,
+                                                                this->input_bits_, gain_db);
+
+    art_resampler::ResampleResult res = art_resampler::resampleProcessInterleavedS16(
+        this->resampler_, input, input_frames, output, output_frames, this->sample_ratio_);
+
+    frames_used = res.input_used;
+    frames_generated = res.output_generated;
+    clipped_samples += res.clipped;
+
+    clipped_samples += quantization_utils::fixed16_to_quantized(output, output_buffer,
+                                                                frames_generated * this->channels_, this->output_bits_);
+  } else {
+    int32_t *input = (int32_t *) this->fixed_input_buffer_;
+    int32_t *output = (int32_t *) this->fixed_output_buffer_;
+
+    clipped_samples += quantization_utils::quantized_to_fixed32(input_buffer, input, input_frames * this->channels_,
+                                                                this->input_bits_, gain_db);
+
+    art_resampler::ResampleResult res = art_resampler::resampleProcessInterleavedS32(
+        this->resampler_, input, input_frames, output, output_frames, this->sample_ratio_);
+
+    frames_used = res.input_used;
+    frames_generated = res.output_generated;
+    clipped_samples += res.clipped;
+
+    clipped_samples += quantization_utils::fixed32_to_quantized(output, output_buffer,
+                                                                frames_generated * this->channels_, this->output_bits_);
+  }
+
+  ResamplerResults results = {.frames_used = frames_used,
+                              .frames_generated = frames_generated,
+                              .predicted_frames_used = input_frames,
                               .clipped_samples = clipped_samples};
   return results;
 }
@@ -0,0 +1,272 @@
+#include "resampler_budget.h"
+
+#include <cmath>
+
+namespace esp_audio_libs {
+namespace resampler {
+
+// Largest tile the Resampler's scratch buffers hold (TILE_FRAMES in resampler.cpp)
+static const size_t RESAMPLER_TILE_FRAMES = 128;
+
+// Quality estimates closer than this are treated as equal, since the measurements aren't more precise
+static const float QUALITY_TOLERANCE_DB = 1.0f;
+
+// Tap and filter counts measured by resampler_benchmark, which are the candidates select_configuration() considers
+static const uint16_t MEASURED_TAPS[] = {8, 16, 32, 64};
+static const uint16_t MEASURED_FILTERS[] = {16, 32, 64, 128};
+static const int MEASURED_TAP_COUNTS = sizeof(MEASURED_TAPS) / sizeof(MEASURED_TAPS[0]);
+static const int MEASURED_FILTER_COUNTS = sizeof(MEASURED_FILTERS) / sizeof(MEASURED_FILTERS[0]);
+
+// resampler_benchmark quality (the smaller of the stopband rejection and the worst THD+N, in dB) of the ART resampler,
+// by taps, filters, and subsample interpolation (off, on), the worst of the 44.1 <-> 48, 22.05 -> 48, and 32 -> 48 kHz
+// pairs with the pre/post filter. Without subsample interpolation the filter count limits it (about 6 dB per
+// doubling), and with it the tap count does.
+static const float ART_QUALITY_DB[MEASURED_TAP_COUNTS][MEASURED_FILTER_COUNTS][2] = {
+    {{17.3f, 17.9f}, {17.7f, 17.8f}, {17.8f, 17.8f}, {17.8f, 17.8f}},
+    {{27.1f, 45.4f}, {33.1f, 45.5f}, {39.1f, 45.5f}, {42.9f, 45.5f}},
+    {{27.1f, 56.7f}, {33.1f, 58.8f}, {39.3f, 59.1f}, {45.0f, 59.1f}},
+    {{27.1f, 59.5f}, {33.1f, 66.9f}, {39.4f, 67.7f}, {45.2f, 67.8f}},
+};
+
+// The same for the IntegerResampler by taps, the worst of the 16 <-> 48 and 96 -> 48 kHz pairs. Its final stage is
+// sized to reject at least as much as the ART resampler with the same taps.
+static const float INTEGER_QUALITY_DB[MEASURED_TAP_COUNTS] = {39.0f, 65.2f, 86.8f, 102.0f};
+
+enum Engine { ENGINE_NONE, ENGINE_INTEGER, ENGINE_INTERPOLATING, ENGINE_ART };
+
+// The engine Resampler::initialize() picks for a configuration
+static Engine get_engine(const ResamplerConfiguration &config) {
+  if ((config.source_sample_rate == config.target_sample_rate) && !config.use_asrc) {
+    return ENGINE_NONE;
+  }
+
+  if (!config.use_fixed_point && !config.use_asrc && !config.use_low_latency &&
+      (config.interpolation_mode == INTERPOLATION_SINC) &&
+      (IntegerResampler::get_factor(config.source_sample_rate, config.target_sample_rate) != 0)) {
+    return ENGINE_INTEGER;
+  }
+
+  if (!config.use_fixed_point && (config.interpolation_mode != INTERPOLATION_SINC)) {
+    return ENGINE_INTERPOLATING;
+  }
+
+  return ENGINE_ART;
+}
+
+// Number of filters of a rational ART context for the configuration, or 0 if Resampler::initialize() doesn't use one
+static uint32_t get_rational_up_factor(const ResamplerConfiguration &config) {
+  const float source = config.source_sample_rate, target = config.target_sample_rate;
+
+  if (!config.use_rational_ratio || config.use_asrc || (source < 1.0f) || (target < 1.0f) ||
+      (floorf(source) != source) || (floorf(target) != target)) {
+    return 0;
+  }
+
+  uint32_t a = (uint32_t) target;
+  uint32_t b = (uint32_t) source;
+  while (b != 0) {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+
+  const uint32_t up_factor = (uint32_t) target / a;
+  return (up_factor <= 1024) ? up_factor : 0;
+}
+
+// Whether the ART resampler's quality was measured for the configuration: resampler_benchmark's tables are for the
+// floating point path with symmetrical filters and interpolated filter phases
+static bool art_quality_measured(const ResamplerConfiguration &config) {
+  return !config.use_fixed_point && !config.use_low_latency && (get_rational_up_factor(config) == 0);
+}
+
+// Index of the largest measured count that's at most count (the smallest if none is)
+static int measured_index(const uint16_t *measured, int measured_counts, uint16_t count) {
+  int index = 0;
+
+  while ((index + 1 < measured_counts) && (measured[index + 1] <= count)) {
+    ++index;
+  }
+
+  return index;
+}
+
+ResamplerCostModel ResamplerCostModel::fit(const ResamplerConfiguration &a, float cost_a,
+                                           const ResamplerConfiguration &b, float cost_b) {
+  const float multiplies_a = estimate_multiplies_per_frame(a);
+  const float multiplies_b = estimate_multiplies_per_frame(b);
+  ResamplerCostModel model = {.frame_cost = 0.0f, .multiply_cost = 0.0f};
+
+  if (multiplies_a != multiplies_b) {
+    model.multiply_cost = (cost_b - cost_a) / (multiplies_b - multiplies_a);
+    model.frame_cost = cost_a - model.multiply_cost * multiplies_a;
+  } else if (multiplies_a > 0.0f) {
+    model.multiply_cost = cost_a / multiplies_a;
+  }
+
+  return model;
+}
+
+// The ART resampler computes one dot product of the taps per channel, or two to interpolate between adjacent filters.
+// The optional biquads (two, or one with interpolation) run at the higher of the two rates.
+float estimate_multiplies_per_frame(const ResamplerConfiguration &config) {
+  const Engine engine = get_engine(config);
+  float multiplies;
+
+  switch (engine) {
+    case ENGINE_NONE:
+      return 0.0f;
+    case ENGINE_INTEGER:
+      return config.channels * IntegerResampler::get_multiplies_per_frame(
+                                   config.source_sample_rate, config.target_sample_rate, config.number_of_taps);
+    case ENGINE_INTERPOLATING:
+      multiplies = (config.interpolation_mode == INTERPOLATION_CUBIC) ? 4.0f : 2.0f;
+      break;
+    default:
+      multiplies = config.number_of_taps;
+      if (config.subsample_interpolate && (get_rational_up_factor(config) == 0)) {
+        multiplies *= 2.0f;
+      }
+      break;
+  }
+
+  if (config.use_pre_or_post_filter && !config.use_fixed_point) {
+    const float biquads = (engine == ENGINE_INTERPOLATING) ? 1.0f : 2.0f;
+    multiplies += 5.0f * biquads * std::max(config.source_sample_rate / config.target_sample_rate, 1.0f);
+  }
+
+  return multiplies * config.channels;
+}
+
+size_t estimate_memory_bytes(const ResamplerConfiguration &config) {
+  const Engine engine = get_engine(config);
+
+  if (engine == ENGINE_NONE) {
+    return 0;
+  }
+
+  const size_t tile_samples = RESAMPLER_TILE_FRAMES * config.channels;
+  size_t size;
+
+  if (config.use_fixed_point) {
+    const size_t sample_bytes =
+        ((config.source_bits_per_sample <= 16) && (config.target_bits_per_sample <= 16)) ? 2 : 4;
+    size = 2 * tile_samples * sample_bytes;
+  } else {
+    size = 2 * tile_samples * sizeof(float) + BIQUAD_CASCADE_STATE_SIZE(2, config.channels) * sizeof(float);
+  }
+
+  switch (engine) {
+    case ENGINE_INTEGER:
+      return size + IntegerResampler::get_memory_size(config.source_sample_rate, config.target_sample_rate,
+                                                      config.channels, config.number_of_taps);
+    case ENGINE_INTERPOLATING:
+      return size + 2 * ((config.interpolation_mode == INTERPOLATION_CUBIC) ? 4 : 2) * config.channels * sizeof(float);
+    default:
+      return size + art_resampler::resampleGetContextSize(config.channels, config.number_of_taps) +
+             art_resampler::resampleGetFilterBankSize(config.number_of_taps, config.number_of_filters,
+                                                      get_rational_up_factor(config),
+                                                      config.use_low_latency ? LOW_LATENCY : 0);
+  }
+}
+
+float estimate_quality_db(const ResamplerConfiguration &config) {
+  const Engine engine = get_engine(config);
+  const int taps = measured_index(MEASURED_TAPS, MEASURED_TAP_COUNTS, config.number_of_taps);
+
+  switch (engine) {
+    case ENGINE_NONE:
+      return INFINITY;
+    case ENGINE_INTEGER:
+      return INTEGER_QUALITY_DB[taps];
+    case ENGINE_INTERPOLATING:
+      return 0.0f;
+    default:
+      break;
+  }
+
+  if (!art_quality_measured(config)) {
+    return 0.0f;
+  }
+
+  const int filters = measured_index(MEASURED_FILTERS, MEASURED_FILTER_COUNTS, config.number_of_filters);
+  return ART_QUALITY_DB[taps][filters][config.subsample_interpolate ? 1 : 0];
+}
+
+bool select_configuration(ResamplerConfiguration &config, const ResamplerBudget &budget) {
+  const Engine engine = get_engine(config);
+
+  if (engine == ENGINE_NONE) {
+    return true;
+  }
+
+  if ((engine == ENGINE_INTERPOLATING) || ((engine == ENGINE_ART) && !art_quality_measured(config))) {
+    return false;
+  }
+
+  // Only the taps matter to the IntegerResampler, so the other parameters are left as they are
+  const bool taps_only = (engine == ENGINE_INTEGER);
+  ResamplerConfiguration candidates[MEASURED_TAP_COUNTS * MEASURED_FILTER_COUNTS * 2];
+  int candidate_count = 0;
+
+  for (uint16_t taps : MEASURED_TAPS) {
+    for (int filters = 0; filters < (taps_only ? 1 : MEASURED_FILTER_COUNTS); ++filters) {
+      for (int subsample = 0; subsample < (taps_only ? 1 : 2); ++subsample) {
+        ResamplerConfiguration candidate = config;
+        candidate.number_of_taps = taps;
+
+        if (!taps_only) {
+          candidate.number_of_filters = MEASURED_FILTERS[filters];
+          candidate.subsample_interpolate = (subsample != 0);
+        }
+
+        const float cost =
+            budget.model.frame_cost + budget.model.multiply_cost * estimate_multiplies_per_frame(candidate);
+
+        if (((budget.max_frame_cost <= 0.0f) || (cost <= budget.max_frame_cost)) &&
+            ((budget.max_memory_bytes == 0) || (estimate_memory_bytes(candidate) <= budget.max_memory_bytes))) {
+          candidates[candidate_count++] = candidate;
+        }
+      }
+    }
+  }
+
+  if (candidate_count == 0) {
+    return false;
+  }
+
+  // The quality to reach: the target if one fits, or else the best that fits. The cheapest candidate reaching it wins,
+  // then the smallest.
+  float best_quality = 0.0f;
+  for (int i = 0; i < candidate_count; ++i) {
+    best_quality = std::max(best_quality, estimate_quality_db(candidates[i]));
+  }
+
+  const float required_quality = ((budget.min_quality_db > 0.0f) && (best_quality >= budget.min_quality_db))
+                                     ? budget.min_quality_db
+                                     : best_quality - QUALITY_TOLERANCE_DB;
+  const ResamplerConfiguration *chosen = nullptr;
+  float chosen_multiplies = 0.0f;
+
+  for (int i = 0; i < candidate_count; ++i) {
+    const ResamplerConfiguration &candidate = candidates[i];
+
+    if (estimate_quality_db(candidate) < required_quality) {
+      continue;
+    }
+
+    const float multiplies = estimate_multiplies_per_frame(candidate);
+
+    if ((chosen == nullptr) || (multiplies < chosen_multiplies) ||
+        ((multiplies == chosen_multiplies) && (estimate_memory_bytes(candidate) < estimate_memory_bytes(*chosen)))) {
+      chosen = &candidate;
+      chosen_multiplies = multiplies;
+    }
+  }
+
+  config = *chosen;
+  return true;
+}
+
+}  // namespace resampler
+}  // namespace esp_audio_libs